@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstddef>
+
+/** Gets the number of heap allocations done by the program so far
+ *  The global operator new is replaced by one that counts every call, so a step can be
+ *  checked to run without allocating.
+ */
+size_t allocationCount();
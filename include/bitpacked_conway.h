@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine.h"
+
+/** Implements a bit-packed 2D engine
+ *  Stores 64 cells per word and evolves B3/S23 on every plane of the world
+ *  using bitwise full-adders, so a whole word of cells is calculated at once.
+ */
+class BitPackedEngine : public Engine
+{
+private:
+    int _N = 0, _M = 0, _D = 0;
+    int _words;                         /* words per row */
+    uint64_t _last_mask;                /* valid bits of the last word of a row */
+    std::vector<uint64_t> _current;     /* packed world, row major, one row every _words words */
+    std::vector<uint64_t> _next;        /* packed world for the next generation */
+
+    /** Calculates the next state of one row
+     * @param up row above
+     * @param row row to be calculated
+     * @param down row below
+     * @param out row of the next generation
+     */
+    void stepRow(const uint64_t *up, const uint64_t *row, const uint64_t *down, uint64_t *out) const;
+
+public:
+    const char *name() const override { return "Bit-packed"; }
+
+    void load(const std::vector<int> &world, int N, int M, int D) override;
+
+    void step(int flag_3d) override;
+
+    void store(std::vector<int> &world) override;
+};
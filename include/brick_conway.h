@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "engine.h"
+#include "thread_pool.h"
+
+/** Double ended queue of bricks shared by the workers
+ *  The owner pops from the back, other workers steal from the front.
+ */
+class WorkDeque
+{
+private:
+    std::mutex _mutex;
+    std::vector<int> _items;
+    int _head = 0, _tail = 0;
+
+public:
+    /** Empties the deque and reserves room for capacity items */
+    void reset(int capacity);
+
+    /** Adds an item at the back, only called before the workers start */
+    void push(int item) { _items[_tail++] = item; }
+
+    /** Takes the item at the back, returns false if empty */
+    bool pop(int &item);
+
+    /** Takes the item at the front, returns false if empty */
+    bool steal(int &item);
+};
+
+/** Implements a 3D engine scheduled by bricks
+ *  The world is split in bricks of BRICK^3 cells that are distributed on one work-stealing
+ *  deque per worker, so workers that run out of bricks take them from the busy ones.
+ *  Bricks that are empty and surrounded by empty bricks are skipped.
+ */
+class BrickEngine : public Engine
+{
+public:
+    static const int BRICK = 16;
+
+    /** Work done by a worker on the last step */
+    struct alignas(64) WorkerStats {
+        double busy = 0;            /* seconds spent calculating bricks */
+        int bricks = 0;             /* bricks calculated */
+        int steals = 0;             /* bricks taken from other workers */
+        float utilisation = 0;      /* busy time over the time of the step */
+    };
+
+private:
+    int _N = 0, _M = 0, _D = 0;
+    int _bricks_i = 0, _bricks_j = 0, _bricks_k = 0;
+    std::vector<uint8_t> _current;          /* one byte per cell, same layout as the dense world */
+    std::vector<uint8_t> _next;
+    std::vector<uint8_t> _occupied;         /* per brick, if it has live cells in _current */
+    std::vector<uint8_t> _next_occupied;    /* per brick, if it has live cells in _next */
+    std::vector<uint8_t> _active;           /* per brick, if it has to be calculated this step */
+    std::vector<int> _prev_i, _next_i, _prev_j, _next_j, _prev_k, _next_k;   /* wrapped neighbour coordinates */
+    int _active_bricks = 0;
+
+    ThreadPool _pool;
+    std::vector<WorkDeque> _deques;
+    std::vector<WorkerStats> _stats;
+
+    /** Calculates a brick, returns if it has live cells */
+    bool stepBrick(int brick, int flag_3d);
+
+    /** Kills every cell of a brick in the next state */
+    void clearBrick(int brick);
+
+    /** Finds if any cell of a brick is alive in a world */
+    bool brickOccupied(const std::vector<uint8_t> &world, int brick) const;
+
+public:
+    /** Constructs the engine
+     * @param workers number of threads used to calculate a step
+     */
+    BrickEngine(int workers = std::thread::hardware_concurrency());
+
+    const char *name() const override { return "Work-stealing bricks"; }
+
+    bool supports_3d() const override { return true; }
+
+    void load(const std::vector<int> &world, int N, int M, int D) override;
+
+    void step(int flag_3d) override;
+
+    void store(std::vector<int> &world) override;
+
+    /** Work done by every worker on the last step */
+    const std::vector<WorkerStats> &stats() const { return _stats; }
+
+    /** Bricks calculated on the last step */
+    int activeBricks() const { return _active_bricks; }
+
+    /** Bricks in the world */
+    int totalBricks() const { return _bricks_i * _bricks_j * _bricks_k; }
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine.h"
+#include "simd_conway.h"
+#include "transport.h"
+
+/** Implements an engine split across processes
+ *  Every rank holds a slab of rows of every plane, with a halo row above and below it. Each
+ *  generation a rank sends its first and last rows to its neighbours and calculates the rows
+ *  that don't need the halos while they travel, then the two rows next to the halos. Rank 0
+ *  drives the others: load scatters the world, step broadcasts a command and store gathers the
+ *  live cells, so the world only crosses the transport when a frame is drawn. The other ranks
+ *  run serve until rank 0 is destroyed.
+ *
+ *  A slab row holds the row of every plane, so a halo is one contiguous message and the 2D and
+ *  3D rules share the same split.
+ */
+class DistributedEngine : public Engine
+{
+private:
+    /** Command sent by rank 0 */
+    struct Command {
+        int32_t op;                     /* one of the ops in distributed_conway.cpp */
+        int32_t flag_3d;
+        int32_t N, M, D;
+        int32_t generations;
+    };
+
+    Transport &_transport;
+    SimdEngine _kernel;                 /* row kernels for the instruction set of the cpu */
+
+    int _N = 0, _M = 0, _D = 0;
+    int _active = 1;                    /* ranks holding rows, the world may have fewer rows than ranks */
+    int _begin = 0, _rows = 0;          /* first row of the slab and amount of rows */
+    std::vector<uint8_t> _current;      /* slab with halos, indexed (row * D + k) * M + j, row 0 is the upper halo */
+    std::vector<uint8_t> _next;
+    std::vector<uint8_t> _sums;         /* column sums of the row being calculated, padded by one on each side */
+    std::vector<uint8_t> _scatter;      /* slab of another rank, used by rank 0 */
+    std::vector<int32_t> _live;         /* indices of the live cells of a slab */
+
+    double _compute_seconds = 0;        /* time spent calculating since load */
+    double _wait_seconds = 0;           /* time spent waiting for halos since load */
+    uint64_t _generation = 0;
+
+    /** First row of the slab of a rank */
+    int slabBegin(int rank) const { return rank < _active ? (int)((int64_t)_N * rank / _active) : _N; }
+
+    /** Sends a command to every other rank, only from rank 0 */
+    void broadcast(const Command &command);
+
+    /** Sizes the slab for a world, every rank calculates the same split */
+    void resize(int N, int M, int D);
+
+    /** Copies the slab of a rank out of a dense world into the slab layout */
+    void packSlab(const std::vector<int> &world, int rank, std::vector<uint8_t> &slab) const;
+
+    /** Runs generations on the slab of this rank, every active rank must call it */
+    void advance(int generations, int flag_3d);
+
+    /** Calculates a row of the slab
+     * @param row row of the slab, from 1 to _rows
+     * @param flag_3d if true uses the 3D rule
+     */
+    void stepRow(int row, int flag_3d);
+
+    /** Gathers the indices of the live cells of this slab into _live */
+    void collectLive();
+
+public:
+    /** Constructs the engine on a transport, it must outlive the engine
+     * @param transport transport shared by every rank
+     */
+    DistributedEngine(Transport &transport);
+
+    /** Rank 0 tells the other ranks to stop serving */
+    ~DistributedEngine();
+
+    const char *name() const override { return "Distributed"; }
+
+    bool supports_3d() const override { return true; }
+
+    void load(const std::vector<int> &world, int N, int M, int D) override;
+
+    void step(int flag_3d) override;
+
+    void store(std::vector<int> &world) override;
+
+    /** Runs several generations with one command, only from rank 0
+     * @param generations amount of generations
+     * @param flag_3d if true uses the 3D rule
+     */
+    void run(int generations, int flag_3d);
+
+    /** Answers the commands of rank 0 until it is destroyed, for every rank but 0 */
+    void serve();
+
+    /** Number of ranks */
+    int ranks() const { return _transport.size(); }
+
+    /** Ranks holding rows of the current world */
+    int activeRanks() const { return _active; }
+
+    /** Generations calculated since load */
+    uint64_t generation() const { return _generation; }
+
+    /** Time rank 0 spent calculating its slab since load */
+    double computeSeconds() const { return _compute_seconds; }
+
+    /** Time rank 0 spent waiting for halos after calculating its inner rows since load */
+    double waitSeconds() const { return _wait_seconds; }
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/** Interface of a CPU simulation engine
+ *  An engine keeps the world in its own representation. The world is loaded from
+ *  and stored to the dense world (one int per cell) used by the renderer.
+ */
+class Engine
+{
+public:
+    virtual ~Engine() {}
+
+    /** Name of the engine, shown in the "Type of simulation" combo */
+    virtual const char *name() const = 0;
+
+    /** If false the engine only implements the 2D rule */
+    virtual bool supports_3d() const { return false; }
+
+    /** Loads a dense world into the engine
+     * @param world vector holding one int per cell
+     * @param N amount of rows in the world
+     * @param M amount of columns in the world
+     * @param D amount of planes in the world
+     */
+    virtual void load(const std::vector<int> &world, int N, int M, int D) = 0;
+
+    /** Loads a dense world that was stored by the engine and then edited
+     *  Engines whose world is larger than the dense one keep the cells outside of it, the others
+     *  load it again.
+     * @param world vector holding one int per cell
+     * @param N amount of rows in the world
+     * @param M amount of columns in the world
+     * @param D amount of planes in the world
+     */
+    virtual void edit(const std::vector<int> &world, int N, int M, int D) { load(world, N, M, D); }
+
+    /** Runs an iteration of the simulation
+     * @param flag_3d if true uses the 3D rule
+     */
+    virtual void step(int flag_3d) = 0;
+
+    /** Generations advanced by every call to step */
+    virtual uint64_t generationsPerStep() const { return 1; }
+
+    /** Writes the world held by the engine into a dense world
+     * @param world vector that will hold one int per cell
+     */
+    virtual void store(std::vector<int> &world) = 0;
+};
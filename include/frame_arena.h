@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+/** Implements an arena for the scratch of a frame
+ *  Memory is handed out from a buffer by bumping a pointer and is never freed on its own, the
+ *  whole arena is released at once when the next frame starts. A frame that doesn't fit in the
+ *  buffer takes the rest from the heap, and the buffer grows on the next reset so the frames
+ *  after it don't allocate.
+ */
+class FrameArena : public std::pmr::memory_resource
+{
+private:
+    /** Takes memory from the heap when the buffer is full and counts it */
+    class Overflow : public std::pmr::memory_resource
+    {
+    public:
+        size_t bytes = 0;   /* bytes taken from the heap since the last reset */
+
+    private:
+        void *do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void *memory, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+    };
+
+    std::vector<std::byte> _buffer;
+    Overflow _overflow;
+    std::optional<std::pmr::monotonic_buffer_resource> _resource;
+    size_t _used = 0;       /* bytes handed out since the last reset */
+    size_t _peak = 0;       /* most bytes handed out in a frame */
+    int _grown = 0;         /* times the buffer grew */
+
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+public:
+    /** Constructs an arena
+     * @param bytes initial size of the buffer
+     */
+    FrameArena(size_t bytes = 1 << 20);
+
+    /** Releases everything handed out since the last reset, called when a frame starts
+     *  Memory taken from it must not be used after this call.
+     */
+    void reset();
+
+    /** Bytes handed out since the last reset */
+    size_t used() const { return _used; }
+
+    /** Most bytes handed out in a frame */
+    size_t peak() const { return _peak; }
+
+    /** Size of the buffer */
+    size_t capacity() const { return _buffer.size(); }
+
+    /** Times the buffer grew because a frame didn't fit */
+    int grown() const { return _grown; }
+};
+
+/** Gathers the positions of the live cells of a world, the scratch the window fills every frame
+ * @param world cells of the world
+ * @param coords three coordinates of every cell
+ * @param cells number of cells of the world
+ * @param positions vector, usually taken from a FrameArena, that will hold the three coordinates of every live cell
+ * @return number of live cells
+ */
+int gatherLiveCells(const std::vector<int> &world, const std::vector<float> &coords, size_t cells, std::pmr::vector<float> &positions);
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine.h"
+
+/** Implements HashLife for the 2D rule
+ *  Every plane is a quadtree of canonical (hash-consed) nodes, so equal regions share one
+ *  node. The RESULT of a node, its center advanced 2^j generations, is memoized on the node,
+ *  which lets a step jump 2^k generations at once. The plane is unbounded: the world is loaded
+ *  around the origin and stored back from the same window, cells outside it are kept but not
+ *  shown, also when the window is edited.
+ */
+class HashLifeEngine : public Engine
+{
+public:
+    /** Node of a quadtree, level 0 nodes are single cells and a level L node is 2^L cells wide */
+    struct Node {
+        int nw, ne, sw, se;         /* children, -1 on cells */
+        int level;
+        int result;                 /* memoized RESULT, -1 if not calculated */
+        int result_step;            /* log2 of the generations advanced by result */
+        int next;                   /* next node in the same hash bucket */
+        uint64_t population;        /* live cells */
+    };
+
+private:
+    int _N = 0, _M = 0, _D = 0;
+    std::vector<Node> _nodes;       /* node 0 is the dead cell and node 1 the live cell */
+    std::vector<int> _buckets;      /* heads of the hash chains of canonical nodes */
+    std::vector<int> _empty;        /* canonical empty node of every level */
+    std::vector<int> _roots;        /* root of every plane, centered on the origin */
+
+    int _jump = 0;                  /* log2 of the generations advanced per step */
+    uint64_t _generation = 0;
+    size_t _memory_cap;             /* bytes of nodes before a garbage collection */
+    int _collections = 0;
+
+    /** Gets the canonical node with the given children */
+    int join(int nw, int ne, int sw, int se);
+
+    /** Gets the canonical empty node of a level */
+    int emptyNode(int level);
+
+    /** Gets a node one level higher with the given node on its center */
+    int expand(int node);
+
+    /** If every live cell of a node S cells wide is on the square of side S/4 on its center
+     *  A successor advances at most S/8 generations, so the cells can't grow past the center
+     *  S/2 square it returns and none is lost on the edges of the node
+     */
+    bool centered(int node) const;
+
+    /** Gets the center of a level 2 node after one generation */
+    int life4x4(int node);
+
+    /** Gets the center of a node after 2^j generations, j is capped at level - 2 */
+    int successor(int node, int j);
+
+    /** Builds the node of a square of a plane
+     * @param y0 first row of the square, relative to the origin
+     * @param x0 first column of the square, relative to the origin
+     */
+    int build(const std::vector<int> &world, int plane, int level, long long y0, long long x0);
+
+    /** Gets a node with the cells of the window taken from a dense world and the ones outside of it from a node
+     * @param node node whose cells outside of the window are kept
+     * @param y0 first row of the node, relative to the origin
+     * @param x0 first column of the node, relative to the origin
+     */
+    int merge(const std::vector<int> &world, int plane, int node, long long y0, long long x0);
+
+    /** Level of the smallest root centered on the origin holding the window, at least 2 */
+    int windowLevel() const;
+
+    /** Writes the live cells of a node that fall on the window into a dense world */
+    void write(std::vector<int> &world, int plane, int node, long long y0, long long x0) const;
+
+    /** Rehashes every canonical node into a table of the given size */
+    void rehash(size_t buckets);
+
+    /** Keeps only the nodes reachable from the roots and compacts them */
+    void collect();
+
+public:
+    /** Constructs the engine
+     * @param memory_cap bytes of nodes allowed before collecting garbage
+     */
+    HashLifeEngine(size_t memory_cap = size_t(512) << 20);
+
+    const char *name() const override { return "HashLife"; }
+
+    void load(const std::vector<int> &world, int N, int M, int D) override;
+
+    /** Rebuilds the nodes that overlap the window from the dense world, the rest of the plane is kept */
+    void edit(const std::vector<int> &world, int N, int M, int D) override;
+
+    /** Advances the world 2^jump generations */
+    void step(int flag_3d) override;
+
+    void store(std::vector<int> &world) override;
+
+    /** Sets log2 of the generations advanced per step */
+    void setJump(int jump) { _jump = jump; }
+
+    uint64_t generationsPerStep() const override { return uint64_t(1) << _jump; }
+
+    /** Sets the bytes of nodes allowed before collecting garbage */
+    void setMemoryCap(size_t memory_cap) { _memory_cap = memory_cap; }
+
+    /** Generations advanced since the world was loaded */
+    uint64_t generation() const { return _generation; }
+
+    /** Canonical nodes alive */
+    size_t nodes() const { return _nodes.size(); }
+
+    /** Bytes used by the nodes and the hash table */
+    size_t memoryUsed() const { return _nodes.size() * sizeof(Node) + _buckets.size() * sizeof(int); }
+
+    /** Garbage collections done since the world was loaded */
+    int collections() const { return _collections; }
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine.h"
+
+/** Implements an engine driven by the cells that changed
+ *  Keeps the number of neighbours of every cell and the list of cells born or dead on the
+ *  last step. Only those cells and their neighbours can change, so only they are evaluated,
+ *  and every birth or death updates the counts of its neighbours. The cost of a step is
+ *  proportional to the activity of the world instead of its size.
+ */
+class IncrementalEngine : public Engine
+{
+private:
+    int _N = 0, _M = 0, _D = 0;
+    int _counts_3d = -1;                /* rule the counts were calculated for, -1 if none */
+    std::vector<uint8_t> _cells;        /* one byte per cell, same layout as the dense world */
+    std::vector<uint8_t> _counts;       /* live neighbours of every cell */
+    std::vector<uint32_t> _stamp;       /* last step a cell was evaluated, avoids evaluating it twice */
+    uint32_t _step = 0;
+
+    std::vector<int> _changed;          /* cells born or dead on the last step */
+    std::vector<int> _candidates;       /* cells to be evaluated on this step */
+    std::vector<int> _flipped;          /* cells born or dead on this step */
+    size_t _evaluated = 0;
+
+    /** Calls fn(neighbour) on every neighbour of a cell, wrapping around the world */
+    template <typename Fn>
+    void forNeighbours(int cell, int flag_3d, Fn fn) const;
+
+    /** Calculates the neighbours of every cell for a rule */
+    void recount(int flag_3d);
+
+public:
+    const char *name() const override { return "Incremental"; }
+
+    bool supports_3d() const override { return true; }
+
+    void load(const std::vector<int> &world, int N, int M, int D) override;
+
+    void step(int flag_3d) override;
+
+    void store(std::vector<int> &world) override;
+
+    /** Cells born or dead on the last step */
+    size_t changed() const { return _changed.size(); }
+
+    /** Cells evaluated on the last step */
+    size_t evaluated() const { return _evaluated; }
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "engine.h"
+#include "rule_conway.h"
+#include "thread_pool.h"
+
+/** Implements a Larger than Life engine
+ *  The box sum of every cell is calculated one axis at a time with a sliding window: the sum of
+ *  a cell is the sum of the one before it, plus the cell entering the window and minus the one
+ *  leaving it. The cost per cell doesn't depend on the radius. Every pass is split among the
+ *  workers of a persistent thread pool.
+ */
+class LtlEngine : public Engine
+{
+private:
+    int _N = 0, _M = 0, _D = 0;
+    LtlRule _rules[2] = {bosco_rule, ltl_rule_3d};
+    std::vector<uint8_t> _current;      /* one byte per cell, same layout as the dense world */
+    std::vector<uint8_t> _next;
+    std::vector<uint16_t> _rows;        /* sums along rows, then in 3D the whole box sums */
+    std::vector<uint16_t> _columns;     /* sums along rows and columns */
+
+    ThreadPool _pool;
+
+    /** Sums every row of a band along its columns, _current to _rows */
+    void sumRows(int begin, int end, int R);
+
+    /** Sums a band of columns of every plane along its rows, _rows to _columns, and in 2D applies the rule */
+    void sumColumns(int begin, int end, const LtlRule &rule, int flag_3d);
+
+    /** Sums a band of cells of a plane along the planes, _columns to _rows, and applies the rule */
+    void sumPlanes(int begin, int end, const LtlRule &rule);
+
+public:
+    /** Constructs the engine
+     * @param workers number of threads used to calculate a step
+     */
+    LtlEngine(int workers = std::thread::hardware_concurrency());
+
+    const char *name() const override { return "Larger than Life"; }
+
+    bool supports_3d() const override { return true; }
+
+    void load(const std::vector<int> &world, int N, int M, int D) override;
+
+    void step(int flag_3d) override;
+
+    void store(std::vector<int> &world) override;
+
+    /** Sets the rule of a dimension, the radius is clamped from 1 to LtlRule::max_radius
+     * @param rule rule to use
+     * @param flag_3d if true sets the rule of the 3D simulation
+     */
+    void setRule(const LtlRule &rule, int flag_3d);
+};
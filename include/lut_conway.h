@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine.h"
+
+/** Implements a 2D engine driven by a lookup table
+ *  Every 4x4 block of cells is packed in a 16 bit key, a table of 65536 entries built for the
+ *  rule gives the next state of its inner 2x2 block, so four cells are calculated per lookup.
+ *  Rows are stored as bits, 64 cells per word. Only implements 2D rules, on every plane.
+ */
+class LutEngine : public Engine
+{
+private:
+    int _N = 0, _M = 0, _D = 0;
+    int _words;                         /* words per row */
+    std::vector<uint8_t> _table;        /* inner 2x2 block of every 4x4 key, one bit per cell */
+    std::vector<uint64_t> _current;     /* packed world, row major, one row every _words words */
+    std::vector<uint64_t> _next;        /* packed world for the next generation */
+    std::vector<uint64_t> _spare;       /* second output row of a world one row high */
+
+    /** Gets 4 bits of a row starting at a column, wrapping around
+     * @param row packed row
+     * @param j first column, may be -1
+     */
+    uint32_t nibble(const uint64_t *row, int j) const;
+
+    /** Calculates two rows of the next generation
+     * @param rows the row above, the two rows to be calculated and the row below
+     * @param out0 first row of the next generation
+     * @param out1 second row of the next generation
+     */
+    void stepRows(const uint64_t *const rows[4], uint64_t *out0, uint64_t *out1) const;
+
+public:
+    /** Builds the table for a rule, as masks of the numbers of neighbours
+     * @param birth bit n set if a dead cell with n neighbours is born
+     * @param survive bit n set if a live cell with n neighbours survives
+     */
+    LutEngine(uint16_t birth = 1 << 3, uint16_t survive = (1 << 2) | (1 << 3));
+
+    const char *name() const override { return "Lookup table"; }
+
+    void load(const std::vector<int> &world, int N, int M, int D) override;
+
+    void step(int flag_3d) override;
+
+    void store(std::vector<int> &world) override;
+};
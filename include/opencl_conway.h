@@ -1,3 +1,7 @@
+#include <array>
+#include <map>
+#include <utility>
+#include <string>
 #include <vector>
 
 #define CL_HPP_TARGET_OPENCL_VERSION 120
@@ -6,6 +10,24 @@
 
 #include <CL/opencl.hpp>
 
+#include "tile_tracker.h"
+#include "rule_conway.h"
+#include "padded_world.h"
+
+/** Lists the OpenCL devices of every platform, in the order of the platforms
+ * @return the devices, empty if there is no OpenCL platform
+ */
+std::vector<cl::Device> listDevices();
+
+/** Picks an OpenCL device
+ * @param selection "gpu", "cpu" or "accelerator" for the first device of that type, the index of a
+ *  device in listDevices, or part of the name of a device or of its platform, ignoring case. If it is
+ *  empty CONWAY_OPENCL_DEVICE is used, and if neither is set or matches a device the first GPU, or the
+ *  first device on hosts without GPUs
+ * @return the device, throws std::runtime_error if there is no OpenCL device
+ */
+cl::Device selectDevice(const std::string &selection = "");
+
 /** Implements a OpenCL command queue
  *  Manages access and updates on the openCL command queue
  */
@@ -15,10 +37,15 @@ private:
     cl::Platform _platform;
     cl::Device _device;
     cl::Context _context;
-    cl::CommandQueue _queue;
+    cl::CommandQueue _queue;                    /* runs the kernels and the blocking transfers */
+    cl::CommandQueue _transfer;                 /* reads the world back while _queue runs kernels */
     std::vector<cl::Buffer> _buffers;
     cl::Kernel _kernel;
-    cl::Program _program;
+    cl::Program _program;                       /* program of the current kernel */
+    std::string _kernel_name;                   /* name of the current kernel */
+    std::string _options;                       /* build options of the current kernel */
+    std::map<std::string, std::pair<cl::Program, cl::Kernel>> _kernels; /* kernels built so far and their programs, by file, name and options */
+    PaddedLayout _padding;                      /* layout of the world in the first two buffers, pitch 0 if it is dense */
 
     void setKernelArgs(int idx) {}
 
@@ -41,9 +68,17 @@ public:
     cl::NDRange globalSize; 
     cl::NDRange localSize;
 
-    /** Constructs a Queue */
+    /** Constructs a Queue on the device picked by selectDevice */
     Queue();
 
+    /** Constructs a Queue on a device
+     * @param device one of listDevices
+     */
+    Queue(const cl::Device &device);
+
+    /** Name of the device of the queue */
+    std::string deviceName() const { return _device.getInfo<CL_DEVICE_NAME>(); }
+
     /** Adds a new OpenCL buffer
      * @param data vector of data to be written in the buffer
      * @param flags type of buffer
@@ -61,11 +96,49 @@ public:
     template <typename T>
     void updateBuffer(std::vector<T> &data, int index);
 
-    /** Reads and loads kernel
+    /** Swaps two buffers, the kernels see each one at the index of the other
+     *  Used to ping-pong the world between two device buffers without copying it.
+     * @param a index of a buffer
+     * @param b index of another buffer
+     */
+    void swapBuffers(int a, int b) { std::swap(_buffers[a], _buffers[b]); }
+
+    /** Reads and loads kernel, a kernel already built with the same options is reused
      * @param file path to kernel file
      * @param kernelName name of the kernel function
+     * @param options options for the OpenCL compiler, like -D definitions
      */
-    void setKernel(const std::string &file, const std::string &kernelName);
+    void setKernel(const std::string &file, const std::string &kernelName, const std::string &options = "");
+
+    /** Creates another kernel object of the current kernel, its arguments are independent of the queue */
+    cl::Kernel newKernel() const { return cl::Kernel(_program, _kernel_name.c_str()); }
+
+    /** OpenCL buffer at an index, in the order they were added */
+    const cl::Buffer &buffer(int index) const { return _buffers[index]; }
+
+    /** Number of buffers, the kernels receive them as their first arguments */
+    int buffers() const { return _buffers.size(); }
+
+    /** OpenCL command queue, kernels enqueued on it run in order */
+    const cl::CommandQueue &commandQueue() const { return _queue; }
+
+    /** Second OpenCL command queue on the same device, for transfers that overlap with the kernels */
+    const cl::CommandQueue &transferQueue() const { return _transfer; }
+
+    /** Build options of the current kernel */
+    const std::string &options() const { return _options; }
+
+    /** Stores the world in the first two buffers with a halo of ghost cells, the transfers of the
+     *  world copy only its cells
+     * @param layout layout of the padded world
+     */
+    void setPadding(const PaddedLayout &layout) { _padding = layout; }
+
+    /** Layout of the world in the first two buffers, its pitch is 0 if the world is dense */
+    const PaddedLayout &padding() const { return _padding; }
+
+    /** Number of kernels built by this queue */
+    size_t kernelsBuilt() const { return _kernels.size(); }
 
     /** Reads an existing OpenCL buffer
      * @param data vector of data to write the buffer
@@ -87,16 +160,235 @@ public:
     cl::Event operator()(cl::NDRange globalSize, cl::NDRange localSize, Args... args);
 };
 
+/** Implements the launches of a step on the world held by the device, with their arguments bound once
+ *  Every launch keeps two kernel objects, one reading the first buffer of the queue and writing
+ *  the second one and the other way around, so the buffers swap roles without setting any
+ *  argument. Launches are enqueued without waiting for them, the next blocking read of the
+ *  queue waits for all of them. Arguments are only bound again when the configuration changes.
+ *
+ *  The world can also be read back on the transfer queue of the Queue while the next
+ *  generations run: enqueueRead reads the last generation enqueued and the following call to
+ *  enqueue only holds back its second generation, the first one that writes the buffer being
+ *  read, until the read is done.
+ */
+class StepPipeline
+{
+public:
+    /** Everything the arguments of a step depend on, compared to know if they have to be bound again */
+    typedef std::array<int, 12> Config;
+
+private:
+    /** A kernel launch of a generation */
+    struct Launch {
+        cl::Kernel kernels[2];          /* reading the first buffer bound, and reading the second one */
+        cl::NDRange global, local;
+    };
+
+    const Queue *_queue = nullptr;
+    Config _config;
+    std::vector<Launch> _launches;
+    cl::Buffer _first;                  /* buffer at index 0 of the queue when the launches were bound */
+    uint64_t _enqueued = 0;             /* launches enqueued so far */
+    double _enqueue_seconds = 0;        /* host time spent enqueueing them */
+
+    /** A read and the batch of generations enqueued after it, whose overlap is measured */
+    struct Overlap {
+        cl::Event read, first, last;    /* the read, the first and the last launch of the batch */
+        bool valid = false;
+    };
+
+    cl::Event _first_launch, _last_launch;  /* first and last launch of the last batch enqueued */
+    cl::Event _read;                        /* last read enqueued */
+    bool _read_pending = false;             /* if true the next batch waits for _read from its second generation */
+    std::vector<cl::Event> _wait_list;      /* holds _read for the launch that waits for it */
+    Overlap _overlaps[2];                   /* the read in flight and the last one done with its batch */
+    double _overlap = 0;                    /* fraction of the last read measured that ran with kernels */
+
+    void bindArgs(cl::Kernel &, int) {}
+
+    /** Binds the scalar arguments after the buffers */
+    template <typename First, typename... Rest>
+    void bindArgs(cl::Kernel &kernel, int idx, First first, Rest... rest)
+    {
+        kernel.setArg(idx, first);
+        bindArgs(kernel, idx + 1, rest...);
+    };
+
+public:
+    /** Starts binding a configuration on a queue, the current one is kept if it is the same
+     * @param q queue holding the kernel, the buffers and the world
+     * @param config configuration of the step
+     * @return true if the launches have to be added again with add
+     */
+    bool configure(const Queue &q, const Config &config);
+
+    /** Adds a launch of the current kernel of the queue to every generation, binding its arguments
+     * @param global total number of threads
+     * @param local threads per group
+     * @param args arguments of the kernel after the buffers
+     * @tparam Args type of the arguments
+     */
+    template <typename... Args>
+    void add(cl::NDRange global, cl::NDRange local, Args... args)
+    {
+        Launch launch;
+        for(int swapped = 0; swapped < 2; swapped++){
+            cl::Kernel &kernel = launch.kernels[swapped] = _queue->newKernel();
+            for(int i = 0; i < _queue->buffers(); i++) kernel.setArg(i, _queue->buffer(i < 2 && swapped ? 1 - i : i));
+            bindArgs(kernel, _queue->buffers(), args...);
+        }
+        launch.global = global;
+        launch.local = local;
+        _launches.push_back(launch);
+    }
+
+    /** Enqueues generations without waiting, the queue swaps its buffers so the first one holds the last generation
+     * @param q queue the pipeline was configured on
+     * @param generations amount of generations
+     */
+    void enqueue(Queue &q, int generations);
+
+    /** Starts reading the last generation enqueued into a vector, on the transfer queue and without waiting
+     * @param q queue the pipeline was configured on
+     * @param world vector that will hold the world, it must not be touched until waitRead returns
+     */
+    void enqueueRead(const Queue &q, std::vector<int> &world);
+
+    /** Waits until the read enqueued by enqueueRead is done */
+    void waitRead();
+
+    /** Percentage of the time of the last read measured that overlapped with the generations enqueued after it */
+    double overlapPercentage() const { return _overlap * 100; }
+
+    /** Average host time spent enqueueing a launch, in microseconds */
+    double enqueueMicroseconds() const { return _enqueued ? _enqueue_seconds * 1e6 / _enqueued : 0; }
+};
+
+/** Implements the simulation of a world split across several OpenCL devices
+ *  Every device holds a slab of consecutive planes between two halo planes, in two buffers that
+ *  swap roles every generation. In 3D the first and last planes of every slab are read back on the
+ *  transfer queue of its device while the planes that don't need the halos are calculated, and
+ *  written into the halos of the slabs next to it before the two planes left are calculated. The
+ *  copies go through the host, so the devices can belong to different platforms. In 2D planes
+ *  don't see each other and nothing is exchanged.
+ */
+class MultiDeviceWorld
+{
+private:
+    /** Slab of the world held by a device */
+    struct Slab {
+        Queue queue;
+        int begin = 0, planes = 0;          /* first plane of the world and amount of planes */
+        cl::Kernel kernels[2][3];           /* inner planes, edge planes and all planes, reading the first and the second buffer */
+        std::vector<int> edges[2];          /* first and last planes read back, one copy per parity of the exchange */
+        cl::Event reads[2];                 /* reads of the first and last planes */
+        std::vector<cl::Event> writes;      /* writes of the halo planes, the kernel of the edge planes waits for them */
+        std::vector<cl::Event> after_step;  /* kernels of the last step, the next reads wait for them */
+        std::vector<cl::Event> halo_step;   /* kernel of the last edge planes, the next writes of the halos wait for it */
+
+        Slab(const cl::Device &device) : queue(device), writes(2) {}
+    };
+
+    int _N, _M, _D;
+    std::vector<Slab> _slabs;
+    int _current = 0;                       /* buffer of every slab holding the world */
+    int _exchange = 0;                      /* copy of the edges written by the next exchange */
+    int _flag_3d = -1;                      /* rule the kernels are bound for */
+    double _wait_seconds = 0;               /* host time spent waiting for the edges */
+    uint64_t _steps = 0;
+
+    /** Binds the arguments of every kernel for a rule */
+    void bind(int flag_3d);
+
+public:
+    /** Splits a world across devices, the planes are divided evenly
+     * @param N amount of rows in the world
+     * @param M amount of columns in the world
+     * @param D amount of planes in the world
+     * @param devices devices to use, only as many as planes are used
+     */
+    MultiDeviceWorld(int N, int M, int D, const std::vector<cl::Device> &devices = listDevices());
+
+    /** Copies a world into the slabs of the devices */
+    void upload(const std::vector<int> &world);
+
+    /** Copies the slabs of the devices into a world, waiting for the steps enqueued */
+    void download(std::vector<int> &world);
+
+    /** Enqueues an iteration of the simulation on every device, it only waits for the edges of the slabs in 3D
+     * @param flag_3d if true treats the world as 3D
+     */
+    void step(int flag_3d);
+
+    /** Number of devices holding a slab */
+    int devices() const { return _slabs.size(); }
+
+    /** Name of the device holding a slab */
+    std::string deviceName(int slab) const { return _slabs[slab].queue.deviceName(); }
+
+    /** Planes of a slab */
+    int slabPlanes(int slab) const { return _slabs[slab].planes; }
+
+    /** Average host time per step spent waiting for the edges of the slabs, in microseconds */
+    double waitMicroseconds() const { return _steps ? _wait_seconds * 1e6 / _steps : 0; }
+};
+
+/** Initializes a world with several gliders in different places
+ * @param world vector that will hold the world
+ * @param N amount of rows in the world
+ * @param M amount of columns in the world
+ */
+void initWorld(std::vector<int> &world, const int N, const int M);
+
 /** Initializes a Command Queue with everything needed to iterate the Conway's Game
+ * Every queue has its own context and device buffers, they are created on a device picked by selectDevice
  * @param N amount of rows in the world
  * @param M amount of columns in the world
  * @param D amount of planes in the world
- * @param type type of kernel implementation to be used
- * @param nextState vector that will hold the next state in the game
+ * @param type type of kernel implementation to be used, 3 calculates only awake tiles, 4 adds neighbourhoods separably,
+ *  5 is generated for a rule by calculateStepGenerated, 6 is for Larger than Life rules, 7 keeps the world with ghost cells
+ * @param nextState world whose size the buffers take, it is not modified
  * @return an initialized Queue
  */
 Queue initConway(int N, int M, int D, int type, std::vector<int> &nextState);
 
+/** Binds the per cell or separable step of a queue to a pipeline
+ * The steps enqueued by the pipeline run on the world held by the device, the first two buffers
+ * swap roles so the first one holds the new generation. The world is copied in by uploadWorld and
+ * out by downloadWorld only when the host needs it.
+ * @param pipeline pipeline that will run the step
+ * @param N amount of rows in the world
+ * @param M amount of columns in the world
+ * @param D amount of planes in the world
+ * @param q queue initialized by initConway with type 0, 1, 2 or 4
+ * @param flag_3d parameter for the kernel, if true treats the world as 3D
+ */
+void prepareStep(StepPipeline &pipeline, int N, int M, int D, Queue &q, int flag_3d);
+
+/** Binds the step of calculateStepGenerated to a pipeline, the kernel is built if needed */
+void prepareStepGenerated(StepPipeline &pipeline, int N, int M, int D, Queue &q, const LifeRule &rule, int flag_3d, Boundary boundary);
+
+/** Binds the passes of calculateStepLtl to a pipeline */
+void prepareStepLtl(StepPipeline &pipeline, int N, int M, int D, Queue &q, const LtlRule &rule, int flag_3d);
+
+/** Binds the passes of calculateStepPadded to a pipeline
+ * @return true if the configuration changed, the halo of the world on the device was filled for
+ *  the last one, so the world has to be copied in again with uploadPaddedWorld
+ */
+bool prepareStepPadded(StepPipeline &pipeline, int N, int M, int D, Queue &q, int flag_3d, Boundary boundary);
+
+/** Copies a world into the first buffer of a queue, the steps on the device start from it
+ * @param q queue initialized by initConway
+ * @param world vector holding the world
+ */
+void uploadWorld(Queue &q, std::vector<int> &world);
+
+/** Copies the world held by the first buffer of a queue, the last one written by a step on the device
+ * @param q queue initialized by initConway
+ * @param world vector that will hold the world
+ */
+void downloadWorld(Queue &q, std::vector<int> &world);
+
 /** Runs an iteration of the simulation
  * @param N amount of rows in the world
  * @param M amount of columns in the world
@@ -105,7 +397,72 @@ Queue initConway(int N, int M, int D, int type, std::vector<int> &nextState);
  * @param nextState vector that will hold the next state in the game
  * @param flag_3d parameter for the kernel, if true treats the world as 3D
  */
-void calculateStep(int N, int M, int D, Queue q, std::vector<int> &nextState, int flag_3d);
+void calculateStep(int N, int M, int D, Queue &q, std::vector<int> &nextState, int flag_3d);
+
+/** Runs an iteration of the simulation only on the tiles that are awake
+ * Needs a Queue initialized with type 3. Sleeping tiles are not calculated, the output
+ * buffer already holds their cells from the last step.
+ * @param N amount of rows in the world
+ * @param M amount of columns in the world
+ * @param D amount of planes in the world
+ * @param q OpenCL command queue that holds the kernel and buffer references
+ * @param nextState vector that will hold the next state in the game
+ * @param flag_3d parameter for the kernel, if true treats the world as 3D
+ * @param tiles tracker of the stable tiles, updated with the tiles that changed
+ */
+void calculateStepTiles(int N, int M, int D, Queue &q, std::vector<int> &nextState, int flag_3d, TileTracker &tiles);
+
+/** Runs an iteration of the simulation with a kernel built for the size, rule and boundary
+ * Needs a Queue initialized with type 5. The kernel is rebuilt when the configuration changes,
+ * the kernels of the configurations already used are kept in the queue.
+ * @param N amount of rows in the world
+ * @param M amount of columns in the world
+ * @param D amount of planes in the world
+ * @param q OpenCL command queue that holds the kernel and buffer references
+ * @param nextState vector that will hold the next state in the game
+ * @param rule rule to apply
+ * @param flag_3d if true treats the world as 3D
+ * @param boundary what the cells on the edges see outside of the world
+ */
+void calculateStepGenerated(int N, int M, int D, Queue &q, std::vector<int> &nextState, const LifeRule &rule, int flag_3d, Boundary boundary);
+
+/** Runs an iteration of a Larger than Life rule
+ * Needs a Queue initialized with type 6. Every pass slides a window along the lines of one axis,
+ * the cost doesn't depend on the radius.
+ * @param N amount of rows in the world
+ * @param M amount of columns in the world
+ * @param D amount of planes in the world
+ * @param q OpenCL command queue that holds the kernel and buffer references
+ * @param nextState vector that will hold the next state in the game
+ * @param rule rule to apply
+ * @param flag_3d if true the box is a cube across planes
+ */
+void calculateStepLtl(int N, int M, int D, Queue &q, std::vector<int> &nextState, const LtlRule &rule, int flag_3d);
+
+/** Copies a world into a queue initialized with type 7 and fills its halo, see uploadWorld
+ * @param N amount of rows in the world
+ * @param M amount of columns in the world
+ * @param D amount of planes in the world
+ * @param q queue initialized with type 7
+ * @param world world to copy
+ * @param flag_3d if true the halo planes are filled too
+ * @param boundary what the cells on the edges see outside of the world
+ */
+void uploadPaddedWorld(int N, int M, int D, Queue &q, std::vector<int> &world, int flag_3d, Boundary boundary);
+
+/** Runs an iteration of the simulation on a world with a halo of ghost cells
+ * Needs a Queue initialized with type 7, the world stays padded on the device. The step reads the
+ * neighbours with plain offsets, and a second pass writes the halo of the next generation from
+ * the cells it copies, so only the ghost cells are mapped to the boundary.
+ * @param N amount of rows in the world
+ * @param M amount of columns in the world
+ * @param D amount of planes in the world
+ * @param q OpenCL command queue that holds the kernel and buffer references
+ * @param nextState vector that will hold the next state in the game
+ * @param flag_3d if true treats the world as 3D
+ * @param boundary what the cells on the edges see outside of the world
+ */
+void calculateStepPadded(int N, int M, int D, Queue &q, std::vector<int> &nextState, int flag_3d, Boundary boundary);
 
 /** Formats and prints a world state to console
  * @param world vector holding the world state
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine.h"
+#include "padded_world.h"
+#include "simd_conway.h"
+#include "world_allocator.h"
+
+/** Implements an engine on a world with ghost cells
+ *  The world keeps a halo of one cell (see PaddedLayout) filled before every step with the
+ *  boundary policy, so the rows around a cell are read with plain offsets and whole padded rows
+ *  go through the row kernels of the SIMD engine without wrapping anything.
+ */
+class PaddedEngine : public Engine
+{
+private:
+    PaddedLayout _layout;
+    Boundary _boundary = Boundary::Toroidal;
+    WorldVector<uint8_t> _current;      /* one byte per cell, padded layout, rows aligned to the pitch */
+    WorldVector<uint8_t> _next;
+    std::vector<uint8_t> _sums;         /* vertical sums of a padded row */
+    SimdEngine _kernel;                 /* row kernels for the instruction set of the cpu */
+
+public:
+    const char *name() const override { return "Ghost cells"; }
+
+    bool supports_3d() const override { return true; }
+
+    void load(const std::vector<int> &world, int N, int M, int D) override;
+
+    void step(int flag_3d) override;
+
+    void store(std::vector<int> &world) override;
+
+    /** Sets what the cells on the edges see outside of the world, used from the next step */
+    void setBoundary(Boundary boundary) { _boundary = boundary; }
+};
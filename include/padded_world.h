@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "rule_conway.h"
+
+/** Describes a world stored with a halo of ghost cells around it
+ *  Every row, plane and the world itself get one extra cell on each side, filled before a step
+ *  with what the cells on the edges see outside of the world. A stencil then reads its neighbours
+ *  with plain offsets (1, pitch and planeSize) instead of wrapping every coordinate. Rows start
+ *  every pitch cells, a multiple of 64 bytes, so they start at the same alignment as the world.
+ */
+struct PaddedLayout
+{
+    static const int row_alignment = 64;   /* bytes the pitch is a multiple of */
+
+    int N = 0, M = 0, D = 0;    /* size of the world without the halo */
+    int pitch = 0;              /* cells from a row to the next one, at least M + 2 */
+    size_t plane_size = 0;      /* cells from a plane to the next one, (N + 2) * pitch */
+
+    PaddedLayout() = default;
+
+    /** Constructs the layout of a world
+     * @param N amount of rows in the world
+     * @param M amount of columns in the world
+     * @param D amount of planes in the world
+     * @param cell_size bytes per cell
+     */
+    PaddedLayout(int N, int M, int D, size_t cell_size);
+
+    /** Cells of the padded world */
+    size_t size() const { return plane_size * (D + 2); }
+
+    /** Ghost cells around the rows and planes of the world, and the two halo planes in 3D */
+    size_t haloCells(int flag_3d) const { return 2 * ((size_t)N * D + (size_t)(M + 2) * D + (flag_3d ? (size_t)(N + 2) * (M + 2) : 0)); }
+
+    /** Index of a cell, coordinates go from -1 to the size of the axis to reach the halo */
+    size_t index(int i, int j, int k) const { return (k + 1) * plane_size + (size_t)(i + 1) * pitch + j + 1; }
+};
+
+/** Copies a dense world into the inside of a padded one, the halo is left as it was
+ * @param layout layout of the padded world
+ * @param dense world indexed k * N * M + i * M + j
+ * @param padded world that will hold the cells
+ * @tparam T type of the padded cells, int or uint8_t
+ */
+template <typename T>
+void padWorld(const PaddedLayout &layout, const int *dense, T *padded);
+
+/** Copies the inside of a padded world into a dense one
+ * @param layout layout of the padded world
+ * @param padded world holding the cells
+ * @param dense world that will hold the cells, indexed k * N * M + i * M + j
+ * @tparam T type of the padded cells, int or uint8_t
+ */
+template <typename T>
+void unpadWorld(const PaddedLayout &layout, const T *padded, int *dense);
+
+/** Fills the halo of a padded world from its edges
+ * Columns are filled first, then rows and then planes copying whole padded rows and planes,
+ * so the edges and corners of the halo see the cells diagonal to them.
+ * @param layout layout of the padded world
+ * @param padded world whose halo is filled
+ * @param boundary Toroidal copies the opposite edge, Dead fills with dead cells and Mirrored
+ *  copies the edge itself
+ * @param flag_3d if false every plane is a world on its own and the halo planes are not filled
+ * @tparam T type of the padded cells, int or uint8_t
+ */
+template <typename T>
+void fillHalo(const PaddedLayout &layout, T *padded, Boundary boundary, int flag_3d);
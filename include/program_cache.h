@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/* Disk cache of built OpenCL programs
+ * A program is stored under a key made of the device, the driver, a hash of the source and the
+ * build options, so a binary is only loaded on the configuration that built it. The cache is kept
+ * in CONWAY_KERNEL_CACHE, kernel/cache if it is not set, and disabled if it is set to "".
+ */
+
+/** Builds the key of a program
+ * @param device name and version of the device
+ * @param driver version of the driver
+ * @param source source of the program
+ * @param options build options
+ * @return the key, a few lines of text
+ */
+std::string programCacheKey(const std::string &device, const std::string &driver, const std::string &source, const std::string &options);
+
+/** Loads the binary of a program from the cache
+ * @param key key of the program
+ * @param binary vector that will hold the binary
+ * @return true if the cache holds a binary for the key
+ */
+bool loadProgramBinary(const std::string &key, std::vector<unsigned char> &binary);
+
+/** Stores the binary of a program in the cache, errors only disable the cache for it
+ * @param key key of the program
+ * @param binary binary of the program built for the device of the key
+ */
+void storeProgramBinary(const std::string &key, const std::vector<unsigned char> &binary);
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+/** Cells counted as neighbours, Moore counts every adjacent cell (8 in 2D, 26 in 3D) and
+ *  von Neumann only the ones sharing a side (4 in 2D, 6 in 3D) */
+enum class Neighbourhood { Moore, VonNeumann };
+
+/** What the cells on the edges of the world see outside of it: the opposite edge, dead cells or
+ *  the edge itself as if reflected by a mirror */
+enum class Boundary { Toroidal, Dead, Mirrored };
+
+/** Gets the mask of a list of numbers of neighbours */
+constexpr uint32_t neighbourCounts(std::initializer_list<int> counts){
+    uint32_t mask = 0;
+    for(int count : counts) mask |= uint32_t(1) << count;
+    return mask;
+}
+
+/** Describes a Life-like rule by the numbers of neighbours that give birth and survival */
+struct LifeRule
+{
+    uint32_t birth;                 /* bit n set if a dead cell with n neighbours is born */
+    uint32_t survive;               /* bit n set if a live cell with n neighbours survives */
+    Neighbourhood neighbourhood;
+
+    bool operator==(const LifeRule &other) const { return birth == other.birth && survive == other.survive && neighbourhood == other.neighbourhood; }
+    bool operator!=(const LifeRule &other) const { return !(*this == other); }
+
+    /** Parses a rule written as B3/S23, counts above 9 are separated by commas (B5/S4,5,10-12)
+     *  and a /V suffix selects the von Neumann neighbourhood
+     * @param text rule to parse
+     * @param rule rule that will hold the result
+     * @return false if the text is not a rule
+     */
+    static bool parse(const std::string &text, LifeRule &rule);
+
+    /** Writes the rule in the format read by parse */
+    std::string toString() const;
+};
+
+/** Rule of the 2D simulation, B3/S23 */
+constexpr LifeRule conway_rule_2d = {neighbourCounts({3}), neighbourCounts({2, 3}), Neighbourhood::Moore};
+
+/** Rule of the 3D simulation, B5/S45 */
+constexpr LifeRule conway_rule_3d = {neighbourCounts({5}), neighbourCounts({4, 5}), Neighbourhood::Moore};
+
+/** Describes a Larger than Life rule, cells count the live cells in a box of radius cells on
+ *  each side (a square in 2D, a cube in 3D) and follow ranges instead of lists */
+struct LtlRule
+{
+    int radius;                     /* cells counted on each side, from 1 to max_radius */
+    int birth_min, birth_max;       /* a dead cell with a count in this range is born */
+    int survive_min, survive_max;   /* a live cell with a count in this range survives */
+    bool count_center;              /* if true the count includes the cell itself */
+
+    static constexpr int max_radius = 10;
+};
+
+/** Bosco's rule, R5 B34-45 S34-58 counting the cell */
+constexpr LtlRule bosco_rule = {5, 34, 45, 34, 58, true};
+
+/** Rule of the 3D simulation as a Larger than Life rule, R1 B5 S4-5 */
+constexpr LtlRule ltl_rule_3d = {1, 5, 5, 4, 5, false};
+
+/** Calculates the next state of a world with a rule known at compile time, the rule is
+ *  evaluated without branches
+ * @param current world holding the current state, one int per cell
+ * @param next world that will hold the next state, can't be the same as current
+ * @param N amount of rows in the world
+ * @param M amount of columns in the world
+ * @param D amount of planes in the world
+ * @tparam Birth numbers of neighbours that give birth, as in LifeRule
+ * @tparam Survive numbers of neighbours that keep a cell alive, as in LifeRule
+ * @tparam Hood neighbourhood counted
+ * @tparam Dims 2 applies the rule on every plane on its own, 3 counts neighbours across planes
+ */
+template <uint32_t Birth, uint32_t Survive, Neighbourhood Hood, int Dims>
+void calculateStepRule(const int *current, int *next, int N, int M, int D);
+
+/** Calculates the next state of a world with any rule, uses a specialized kernel when the rule
+ *  has one and a generic kernel reading the masks at runtime otherwise
+ * @param current world holding the current state, one int per cell
+ * @param next world that will hold the next state, can't be the same as current
+ * @param N amount of rows in the world
+ * @param M amount of columns in the world
+ * @param D amount of planes in the world
+ * @param rule rule to apply
+ * @param flag_3d if true treats the world as 3D
+ */
+void calculateStepRule(const int *current, int *next, int N, int M, int D, const LifeRule &rule, int flag_3d);
+
+/** Returns true if a rule has a kernel specialized at compile time
+ * @param rule rule to look for
+ * @param flag_3d if true looks for the 3D kernel
+ */
+bool ruleSpecialized(const LifeRule &rule, int flag_3d);
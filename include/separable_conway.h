@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine.h"
+#include "simd_conway.h"
+
+/** Implements an engine that adds neighbourhoods separably
+ *  The 3x3x3 box sum of every cell is calculated one axis at a time: every row is added with
+ *  the rows above and below it, in 3D the result is added with the ones of the planes before
+ *  and after, and last every column with its left and right columns. The sums of a plane are
+ *  kept while the next two planes use them, so a cell costs about six adds and every pass reads
+ *  memory in order. The passes use the row kernels of the SIMD engine.
+ */
+class SeparableEngine : public Engine
+{
+private:
+    int _N = 0, _M = 0, _D = 0;
+    std::vector<uint8_t> _current;      /* one byte per cell, same layout as the dense world */
+    std::vector<uint8_t> _next;
+    std::vector<uint8_t> _plane_sums;   /* vertical sums of three planes, reused as the window moves */
+    std::vector<uint8_t> _sums;         /* sums of the row being calculated, padded by one on each side */
+    SimdEngine _kernel;                 /* row kernels for the instruction set of the cpu */
+
+    /** Adds every row of a plane with the rows above and below it
+     * @param k plane
+     * @param out plane that will hold the sums
+     */
+    void verticalSums(int k, uint8_t *out) const;
+
+public:
+    const char *name() const override { return "Separable sums"; }
+
+    bool supports_3d() const override { return true; }
+
+    void load(const std::vector<int> &world, int N, int M, int D) override;
+
+    void step(int flag_3d) override;
+
+    void store(std::vector<int> &world) override;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "tile_tracker.h"
+
+/** Returns 1d coordinates from 3d coordinates, wrapping around the world
+ * @param i x coordinate
+ * @param j y coordinate
+ * @param k z coordiante
+ * @param N number of rows
+ * @param M number of columns
+ * @param D number of planes
+ */
+inline int worldIdx(int i, int j, int k, const int N, const int M, const int D){
+    k = (k + D) % D;
+    i = (i + N) % N;
+    j = (j + M) % M;
+	return k * N * M + i * M + j;
+}
+
+/** Calculates the next state of a world with a sequential pass through every cell
+ * @param current world holding the current state, one int per cell
+ * @param next world that will hold the next state, can't be the same as current
+ * @param N amount of rows in the world
+ * @param M amount of columns in the world
+ * @param D amount of planes in the world
+ * @param flag_3d if true treats the world as 3D
+ */
+void calculateStepSequential(const int *current, int *next, int N, int M, int D, int flag_3d);
+
+/** Calculates the next state of the awake tiles of a world, sleeping tiles are not written
+ * @param current world holding the current state, one int per cell
+ * @param next world that will hold the next state of the awake tiles
+ * @param N amount of rows in the world
+ * @param M amount of columns in the world
+ * @param D amount of planes in the world
+ * @param flag_3d if true treats the world as 3D
+ * @param tiles tracker of the stable tiles, updated with the tiles that changed
+ */
+void calculateStepSequentialTiles(const int *current, int *next, int N, int M, int D, int flag_3d, TileTracker &tiles);
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine.h"
+
+/** Implements a vectorized engine
+ *  Stores one byte per cell and calculates a whole row per iteration: the rows around it
+ *  are added with vector adds and the rule is evaluated with vector compares. The instruction
+ *  set (SSE4.2, AVX2 or AVX-512) is picked at runtime, scalar code is used on non-x86 hosts.
+ *  Wrapping only happens at the edges.
+ */
+class SimdEngine : public Engine
+{
+public:
+    /** Adds a row into an accumulator, acc[j] += row[j] for j < M */
+    typedef void (*AddRowFn)(uint8_t *acc, const uint8_t *row, int M);
+
+    /** Sums each column with its neighbours and applies the rule
+     * @param sums column sums with a wrapped copy at sums[-1] and sums[M]
+     * @param center cells of the row being calculated
+     * @param out row of the next generation
+     * @param M amount of columns
+     * @param target value of (neighbours | cell) for a cell to be alive
+     */
+    typedef void (*ApplyRuleFn)(const uint8_t *sums, const uint8_t *center, uint8_t *out, int M, uint8_t target);
+
+private:
+    int _N = 0, _M = 0, _D = 0;
+    std::vector<uint8_t> _current;      /* one byte per cell, same layout as the dense world */
+    std::vector<uint8_t> _next;
+    std::vector<uint8_t> _sums;         /* column sums of the row being calculated, padded by one on each side */
+
+    const char *_name;
+    AddRowFn _add_row;
+    ApplyRuleFn _apply_rule;
+
+public:
+    /** Constructs the engine with the widest instruction set supported by the cpu */
+    SimdEngine();
+
+    const char *name() const override { return _name; }
+
+    bool supports_3d() const override { return true; }
+
+    void load(const std::vector<int> &world, int N, int M, int D) override;
+
+    void step(int flag_3d) override;
+
+    void store(std::vector<int> &world) override;
+
+    /** Calculates a range of rows of a world, rows are numbered across planes (k * N + i)
+     * @param current world holding the current state, one byte per cell
+     * @param next world that will hold the next state
+     * @param sums scratch of M + 2 bytes
+     * @param N amount of rows in the world
+     * @param M amount of columns in the world
+     * @param D amount of planes in the world
+     * @param begin first row to calculate
+     * @param end row after the last one to calculate
+     * @param flag_3d if true uses the 3D rule
+     */
+    void stepRows(const uint8_t *current, uint8_t *next, uint8_t *sums, int N, int M, int D, int begin, int end, int flag_3d) const;
+
+    /** Adds a row into an accumulator with the instruction set of the cpu, see AddRowFn */
+    void addRow(uint8_t *acc, const uint8_t *row, int M) const { _add_row(acc, row, M); }
+
+    /** Applies the rule to a row with the instruction set of the cpu, see ApplyRuleFn */
+    void applyRule(const uint8_t *sums, const uint8_t *center, uint8_t *out, int M, uint8_t target) const { _apply_rule(sums, center, out, M, target); }
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "engine.h"
+
+/** Implements an unbounded world made of chunks
+ *  The world is a hash map of chunks of 32x32 cells in 2D and 16x16x16 in 3D, allocated when
+ *  a cell may be born on them and released when they become empty, so memory depends on the
+ *  live area and not on how far the cells travel. There is no wrap around: the dense world is
+ *  a window over the unbounded one, and cells outside the window are kept but not shown, also
+ *  when the window is edited.
+ */
+class SparseEngine : public Engine
+{
+public:
+    /** Bounding box of the live cells, inclusive */
+    struct Box {
+        long long min_i, min_j, min_k;
+        long long max_i, max_j, max_k;
+        bool empty;
+    };
+
+private:
+    struct Key {
+        int i, j, k;
+        bool operator==(const Key &other) const { return i == other.i && j == other.j && k == other.k; }
+    };
+    struct KeyHash {
+        size_t operator()(const Key &key) const { return ((size_t)key.i * 73856093) ^ ((size_t)key.j * 19349663) ^ ((size_t)key.k * 83492791); }
+    };
+
+    int _N = 0, _M = 0, _D = 0;
+    int _flag_3d = 0;                       /* rule the chunks are shaped for */
+    int _ci = 32, _cj = 32, _ck = 1;        /* cells per chunk on each axis */
+    std::unordered_map<Key, int, KeyHash> _chunks;     /* chunk coordinates to slot */
+    std::vector<uint8_t> _pool;             /* two buffers of cells per slot, current and next */
+    std::vector<Key> _keys;                 /* per slot, coordinates of its chunk */
+    std::vector<uint8_t> _alive;            /* per slot, if its current buffer has live cells */
+    std::vector<int> _free;                 /* released slots */
+    int _parity = 0;                        /* buffer of the slots holding the current state */
+
+    long long _view_i = 0, _view_j = 0, _view_k = 0;   /* first cell of the window */
+    bool _follow = false;
+    Box _box;
+
+    std::vector<Key> _grow;                 /* scratch, chunks that need neighbours */
+    std::vector<uint8_t> _padded;           /* scratch, a chunk with one cell of its neighbours around */
+
+    int chunkCells() const { return _ci * _cj * _ck; }
+
+    /** Cells of a slot on one of its buffers */
+    uint8_t *cells(int slot, int buffer) { return &_pool[((size_t)slot * 2 + buffer) * chunkCells()]; }
+
+    /** Gets the slot of a chunk, creating an empty one if needed */
+    int chunk(const Key &key);
+
+    /** Key of the chunk holding a cell */
+    Key keyOf(long long i, long long j, long long k) const;
+
+    /** Adds a live cell */
+    void setAlive(long long i, long long j, long long k);
+
+    /** Shapes the chunks for a rule, moving every live cell */
+    void reshape(int flag_3d);
+
+    /** Copies a chunk and the borders of its neighbours to _padded */
+    void gather(int slot);
+
+    /** Calculates the next state of a chunk, returns if it has live cells and grows the box */
+    bool stepChunk(int slot, int flag_3d);
+
+    /** Moves the window to the center of the box */
+    void centerView();
+
+public:
+    const char *name() const override { return "Unbounded"; }
+
+    bool supports_3d() const override { return true; }
+
+    /** Loads the dense world at the position of the window */
+    void load(const std::vector<int> &world, int N, int M, int D) override;
+
+    /** Writes the dense world over the cells of the window, the chunks outside of it are kept */
+    void edit(const std::vector<int> &world, int N, int M, int D) override;
+
+    void step(int flag_3d) override;
+
+    /** Writes the cells inside of the window */
+    void store(std::vector<int> &world) override;
+
+    /** If true the window follows the center of the live cells after every step */
+    void setFollow(bool follow) { _follow = follow; }
+
+    /** Bounding box of the live cells after the last step */
+    const Box &boundingBox() const { return _box; }
+
+    /** First cell of the window on each axis */
+    long long viewRow() const { return _view_i; }
+    long long viewCol() const { return _view_j; }
+    long long viewPlane() const { return _view_k; }
+
+    /** Chunks allocated */
+    size_t chunks() const { return _chunks.size(); }
+
+    /** Bytes held by the chunk pool */
+    size_t memoryUsed() const { return _pool.size(); }
+};
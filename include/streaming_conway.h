@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "engine.h"
+#include "simd_conway.h"
+
+/** Implements an engine for worlds larger than memory
+ *  The world lives in a file, one bit per cell, that is memory-mapped and read one plane at a
+ *  time through a rolling window of three unpacked planes (the one being calculated and the two
+ *  next to it). The next generation is written plane by plane into a second file, and the two
+ *  files swap roles after every step, so a step reads one file and writes the other in order.
+ *  Only the window is held in memory, 3 * rows * cols bytes.
+ */
+class StreamingEngine : public Engine
+{
+public:
+    /** Header at the start of a world file, the planes start at data_offset */
+    struct FileHeader {
+        char magic[8];              /* "CONWAY3D" */
+        uint32_t rows, cols, planes;
+        uint32_t reserved;
+        uint64_t generation;
+    };
+
+    static const size_t data_offset = 4096;     /* planes start on their own page */
+
+private:
+    /** A world file mapped in memory */
+    struct File {
+        int fd = -1;
+        uint8_t *data = nullptr;
+        size_t size = 0;
+    };
+
+    int _N = 0, _M = 0, _D = 0;
+    size_t _row_words = 0;              /* 64 bit words per row */
+    size_t _plane_bytes = 0;            /* bytes per packed plane */
+    uint64_t _generation = 0;
+
+    std::string _load_path;             /* file of the worlds loaded with load */
+    std::string _paths[2];              /* files of the two generations */
+    File _files[2];
+    int _current = 0;                   /* file holding the current generation */
+    bool _temporary = true;             /* if true the files are removed with the engine */
+
+    std::vector<uint8_t> _window;       /* three unpacked planes */
+    std::vector<uint8_t> _out;          /* unpacked plane of the next generation */
+    std::vector<uint8_t> _sums;         /* column sums of a row, padded by one on each side */
+    SimdEngine _kernel;                 /* row kernels for the instruction set of the cpu */
+
+    double _planes_per_second = 0;
+
+    /** Maps a file, creating it with the given size if it doesn't have it
+     * @return false if the file can't be opened or mapped
+     */
+    bool mapFile(int index, size_t size);
+
+    /** Unmaps and closes the files, removing them if they are temporary */
+    void closeFiles();
+
+    /** Sets the size of the world and sizes the window */
+    void setSize(int N, int M, int D);
+
+    /** Packed plane of a file */
+    uint8_t *plane(int file, int k) const { return _files[file].data + data_offset + (size_t)k * _plane_bytes; }
+
+    /** Unpacks a plane of a file, one byte per cell */
+    void unpackPlane(int file, int k, uint8_t *cells) const;
+
+    /** Packs a plane into a file */
+    void packPlane(const uint8_t *cells, int file, int k);
+
+    /** Writes the header of a file */
+    void writeHeader(int file);
+
+public:
+    /** Constructs the engine
+     * @param path file of the world loaded with load, the next generation goes to path + ".next";
+     *  by default a file in the temporary directory
+     */
+    StreamingEngine(const std::string &path = "");
+
+    ~StreamingEngine();
+
+    const char *name() const override { return "Out of core"; }
+
+    bool supports_3d() const override { return true; }
+
+    void load(const std::vector<int> &world, int N, int M, int D) override;
+
+    void step(int flag_3d) override;
+
+    void store(std::vector<int> &world) override;
+
+    /** Opens a world file written by createWorldFile or by an earlier run, it's kept when the
+     *  engine is destroyed. The world doesn't have to fit in memory, but it can only be stored
+     *  into a dense world if it does.
+     * @param path world file, the next generation goes to path + ".next"
+     * @return false if the file is not a world file or can't be mapped
+     */
+    bool open(const std::string &path);
+
+    /** Writes a world file with random cells, one plane at a time
+     * @param path file to write
+     * @param N amount of rows in the world
+     * @param M amount of columns in the world
+     * @param D amount of planes in the world
+     * @param density probability of a cell being alive
+     * @param seed seed of the random cells
+     * @return false if the file can't be written
+     */
+    static bool createWorldFile(const std::string &path, int N, int M, int D, double density, uint32_t seed);
+
+    /** Planes calculated per second on the last step */
+    double planesPerSecond() const { return _planes_per_second; }
+
+    /** Generations calculated since the world was loaded or created */
+    uint64_t generation() const { return _generation; }
+
+    /** File holding the current generation */
+    const std::string &currentPath() const { return _paths[_current]; }
+
+    int rows() const { return _N; }
+    int cols() const { return _M; }
+    int planes() const { return _D; }
+};
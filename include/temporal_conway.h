@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine.h"
+#include "simd_conway.h"
+
+/** Implements an engine with temporal blocking
+ *  Splits the world in tiles of 256 rows (24 rows and 24 planes in 3D) and advances every tile several
+ *  generations before writing it back. A tile is read with a border of one cell per generation,
+ *  the border shrinks by one cell every generation, so the inner tile is exact at the end. The
+ *  tile stays in cache meanwhile, the world goes through memory once per step instead of once
+ *  per generation. Tiles are tile_width columns wide with their border, so rows fill whole vectors
+ *  of the row kernel.
+ */
+class TemporalEngine : public Engine
+{
+private:
+    int _N = 0, _M = 0, _D = 0;
+    int _generations;                   /* generations advanced per step */
+    std::vector<uint8_t> _current;      /* one byte per cell, same layout as the dense world */
+    std::vector<uint8_t> _next;
+    std::vector<uint8_t> _tile[2];      /* a tile with its border, for two generations */
+    std::vector<int> _columns;          /* column of the world of every column of the tile */
+    std::vector<uint8_t> _sums;         /* scratch of the row kernel */
+    SimdEngine _kernel;                 /* row kernel for the instruction set of the cpu */
+
+    /** Advances a tile _generations generations and writes it to _next
+     * @param i0 first row of the tile
+     * @param j0 first column of the tile
+     * @param k0 first plane of the tile
+     * @param ti rows of the tile
+     * @param tj columns of the tile
+     * @param tk planes of the tile
+     * @param flag_3d if True the 3D rule is used
+     */
+    void stepTile(int i0, int j0, int k0, int ti, int tj, int tk, int flag_3d);
+
+public:
+    static const int tile_width = 256;
+    static const int tile_rows_2d = 256;
+    static const int tile_size_3d = 24;
+    static const int max_generations = 8;
+
+    /** @param generations generations advanced per step, from 1 to max_generations */
+    TemporalEngine(int generations = 4);
+
+    const char *name() const override { return "Temporal blocking"; }
+
+    bool supports_3d() const override { return true; }
+
+    void load(const std::vector<int> &world, int N, int M, int D) override;
+
+    /** Advances the world generations() generations */
+    void step(int flag_3d) override;
+
+    void store(std::vector<int> &world) override;
+
+    /** Sets the generations advanced per step, clamped from 1 to max_generations */
+    void setGenerations(int generations);
+
+    int generations() const { return _generations; }
+
+    uint64_t generationsPerStep() const override { return _generations; }
+};
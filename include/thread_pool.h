@@ -0,0 +1,72 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/** Implements a persistent pool of threads
+ *  The threads are created once and wait for jobs, so running a job doesn't create threads.
+ *  A job runs once on every worker, each call receives the index of its worker.
+ */
+class ThreadPool
+{
+private:
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _start;
+    std::condition_variable _done;
+
+    void (*_fn)(void*, int) = nullptr;  /* current job, called with _job and the worker index */
+    void *_job = nullptr;
+    int _generation = 0;                /* increases with every job, wakes up the workers */
+    int _pending = 0;                   /* workers that haven't finished the current job */
+    bool _stop = false;
+    std::vector<int> _nodes;            /* NUMA node of every worker, 0 until they are pinned */
+
+    /** Loop run by every thread of the pool
+     * @param worker index of the worker
+     */
+    void workerLoop(int worker);
+
+    /** Runs fn(job, worker) on every worker and waits for all of them */
+    void dispatch(void (*fn)(void*, int), void *job);
+
+    template <typename Job>
+    static void invoke(void *job, int worker)
+    {
+        (*static_cast<Job*>(job))(worker);
+    };
+
+public:
+    /** Constructs a pool
+     * @param workers number of workers, the calling thread is used as worker 0
+     */
+    ThreadPool(int workers = std::thread::hardware_concurrency());
+
+    ~ThreadPool();
+
+    /** Number of workers, including the calling thread */
+    int size() const { return _threads.size() + 1; }
+
+    /** Pins the threads of the pool to cpus the process can run on
+     *  Cpus are taken node by node, so workers with consecutive indices share a node. Worker 0,
+     *  the calling thread, is left unpinned and reports the node it runs on.
+     * @return number of workers pinned
+     */
+    int pin();
+
+    /** NUMA node of a worker, 0 if the pool is not pinned */
+    int node(int worker) const { return _nodes[worker]; }
+
+    /** Runs a job on every worker and waits for all of them
+     * @param job callable as job(int worker)
+     * @tparam Job type of the job
+     */
+    template <typename Job>
+    void run(Job &&job)
+    {
+        dispatch(&invoke<typename std::remove_reference<Job>::type>, (void*)&job);
+    };
+};
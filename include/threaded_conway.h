@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine.h"
+#include "simd_conway.h"
+#include "thread_pool.h"
+#include "world_allocator.h"
+
+/** Implements a multithreaded engine
+ *  The world is split in one band of rows per worker of a persistent thread pool,
+ *  in 3D the bands are slabs of planes. Every band is calculated with the SIMD row kernel.
+ *  Workers are pinned to cpus and touch their bands first when the world is loaded, so the
+ *  pages of every band are placed on the NUMA node of the worker that steps it.
+ */
+class ThreadedEngine : public Engine
+{
+private:
+    int _N = 0, _M = 0, _D = 0;
+    WorldVector<uint8_t> _current;      /* one byte per cell, same layout as the dense world */
+    WorldVector<uint8_t> _next;
+    std::vector<uint8_t> _sums;         /* column sums scratch, M + 2 bytes per worker */
+
+    ThreadPool _pool;
+    SimdEngine _kernel;                 /* row kernel for the instruction set of the cpu */
+
+    /** First row of the band of a worker, rows are numbered across planes */
+    int bandBegin(int worker) const { return (long long)_N * _D * worker / _pool.size(); }
+
+public:
+    /** Constructs the engine
+     * @param workers number of threads used to calculate a step
+     * @param pin if true pins the workers to cpus, the calling thread included
+     */
+    ThreadedEngine(int workers = std::thread::hardware_concurrency(), bool pin = true);
+
+    const char *name() const override { return "Multithreaded"; }
+
+    bool supports_3d() const override { return true; }
+
+    void load(const std::vector<int> &world, int N, int M, int D) override;
+
+    void step(int flag_3d) override;
+
+    void store(std::vector<int> &world) override;
+
+    /** Number of threads used */
+    int workers() const { return _pool.size(); }
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** Tracks which tiles of a dense world are stable
+ *  The world is split in tiles of 32x32 cells in 2D and 8x8x8 in 3D. A tile that didn't
+ *  change on the last step and whose neighbour tiles (its halo) didn't either can't change
+ *  on this one, so it sleeps: it's not calculated and its cells stay as they are.
+ */
+class TileTracker
+{
+private:
+    int _N = 0, _M = 0, _D = 0, _flag_3d = -1;
+    int _tile_i = 1, _tile_j = 1, _tile_k = 1;          /* cells per tile on each axis */
+    int _tiles_i = 0, _tiles_j = 0, _tiles_k = 0;       /* tiles on each axis */
+    uint64_t _generation = 0;
+    std::vector<uint64_t> _stable_since;    /* per tile, generation since which it hasn't changed */
+    std::vector<int> _awake;                /* tiles to calculate on this step */
+    std::vector<int> _changed;              /* per tile, set by the step if any of its cells changed */
+
+public:
+    /** Sets the world and the rule, wakes every tile if any of them changed
+     * @param N amount of rows in the world
+     * @param M amount of columns in the world
+     * @param D amount of planes in the world
+     * @param flag_3d if true uses 3D tiles and neighbourhoods
+     */
+    void configure(int N, int M, int D, int flag_3d);
+
+    /** Wakes every tile, used when the world is changed outside of the step */
+    void wakeAll();
+
+    /** Gets the tiles to calculate on this step, the ones with a tile that changed on their halo */
+    std::vector<int> &prepare();
+
+    /** Per tile flags, the step sets the ones of the tiles that changed */
+    std::vector<int> &changed() { return _changed; }
+
+    /** Updates the stable generation of every tile after the step */
+    void finish();
+
+    /** Calls fn(i, j, k) on every cell of a tile */
+    template <typename Fn>
+    void forCells(int tile, Fn fn) const
+    {
+        int tk = tile / (_tiles_i * _tiles_j), ti = (tile / _tiles_j) % _tiles_i, tj = tile % _tiles_j;
+        for(int k = tk * _tile_k; k < _D && k < (tk + 1) * _tile_k; k++){
+            for(int i = ti * _tile_i; i < _N && i < (ti + 1) * _tile_i; i++){
+                for(int j = tj * _tile_j; j < _M && j < (tj + 1) * _tile_j; j++) fn(i, j, k);
+            }
+        }
+    };
+
+    int tileRows() const { return _tile_i; }
+    int tileCols() const { return _tile_j; }
+    int tilePlanes() const { return _tile_k; }
+    int tileCells() const { return _tile_i * _tile_j * _tile_k; }
+    int totalTiles() const { return _tiles_i * _tiles_j * _tiles_k; }
+    int awakeTiles() const { return _awake.size(); }
+
+    /** Generation since which a tile hasn't changed */
+    uint64_t stableSince(int tile) const { return _stable_since[tile]; }
+
+    /** Number of tiles of a world, the largest of the 2D and 3D tilings
+     * @param N amount of rows in the world
+     * @param M amount of columns in the world
+     * @param D amount of planes in the world
+     */
+    static int maxTiles(int N, int M, int D);
+};
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+
+/** Interface of the transport between the processes (ranks) of a distributed run
+ *  Sends and receives are started without waiting and completed together by wait, so a rank can
+ *  calculate while its messages travel. Messages between two ranks with the same tag arrive in
+ *  the order they were sent, a receive gets the oldest message from its rank with its tag.
+ */
+class Transport
+{
+public:
+    virtual ~Transport() {}
+
+    /** Index of this process, rank 0 drives the others */
+    virtual int rank() const = 0;
+
+    /** Number of processes */
+    virtual int size() const = 0;
+
+    /** Starts sending a message, data must stay unchanged until wait returns
+     * @param to rank receiving it, not this one
+     * @param tag tag of the message
+     * @param data bytes to send
+     * @param bytes size of the message
+     */
+    virtual void isend(int to, int tag, const void *data, size_t bytes) = 0;
+
+    /** Starts receiving a message, data must not be read until wait returns
+     * @param from rank sending it, not this one
+     * @param tag tag of the message
+     * @param data buffer that will hold the message
+     * @param bytes size of the message, it must be the size sent
+     */
+    virtual void irecv(int from, int tag, void *data, size_t bytes) = 0;
+
+    /** Waits until every send and receive started is done */
+    virtual void wait() = 0;
+
+    /** Sends a message and waits for it */
+    void send(int to, int tag, const void *data, size_t bytes) { isend(to, tag, data, bytes); wait(); }
+
+    /** Receives a message and waits for it */
+    void recv(int from, int tag, void *data, size_t bytes) { irecv(from, tag, data, bytes); wait(); }
+};
+
+/** Implements a transport over TCP or Unix domain sockets
+ *  Every pair of ranks shares a connection: every rank listens on its own address, connects to
+ *  the ranks before it and accepts the ranks after it. Sends write as much as the socket takes
+ *  right away, so halos usually travel through the kernel buffers while the ranks calculate;
+ *  wait finishes the rest.
+ */
+class SocketTransport : public Transport
+{
+private:
+    /** Header written before every message */
+    struct Header {
+        int32_t tag;
+        uint32_t reserved;
+        uint64_t bytes;
+    };
+
+    /** A send started and not written yet */
+    struct Send {
+        Header header;
+        const char *data;
+        size_t done;                    /* bytes of the header and the message already written */
+    };
+
+    /** A receive started and not matched to a message yet */
+    struct Receive {
+        int tag;
+        char *data;
+        size_t bytes;
+    };
+
+    /** A message that arrived before its receive was started */
+    struct Message {
+        int tag;
+        std::vector<char> data;
+    };
+
+    /** Connection to another rank */
+    struct Peer {
+        int fd = -1;
+        std::deque<Send> sends;
+        std::deque<Receive> receives;
+        std::deque<Message> unexpected;
+
+        Header header;                  /* header of the message being read */
+        size_t done = 0;                /* bytes of the header and the message already read */
+        char *target = nullptr;         /* where the message being read goes */
+        bool matched = false;           /* if false the message goes to unexpected */
+    };
+
+    int _rank, _size;
+    std::vector<Peer> _peers;           /* one per rank, this rank has no connection */
+    std::vector<pollfd> _polls;         /* scratch of wait */
+
+    /** Writes sends of a peer until the socket is full
+     * @return true if every send of the peer is written
+     */
+    bool writeSends(Peer &peer);
+
+    /** Reads messages of a peer until the socket is empty or every receive is matched
+     * @return true if every receive of the peer is done
+     */
+    bool readMessages(Peer &peer);
+
+public:
+    /** Connects to every rank, blocks until all of them are up, throws std::runtime_error if it can't
+     * @param rank index of this process
+     * @param addresses address of every rank, "unix:<path>" or "<host>:<port>"
+     */
+    SocketTransport(int rank, const std::vector<std::string> &addresses);
+
+    ~SocketTransport();
+
+    int rank() const override { return _rank; }
+
+    int size() const override { return _size; }
+
+    void isend(int to, int tag, const void *data, size_t bytes) override;
+
+    void irecv(int from, int tag, void *data, size_t bytes) override;
+
+    void wait() override;
+};
+
+/** Creates a transport from a description
+ *  "mpi" uses MPI when the program was built with it. "unix:<path>" gives rank r the socket
+ *  <path>.<r>, "tcp:<host>:<port>" gives rank r the port <port> + r on one host, and
+ *  "tcp:<host>:<port>,<host>:<port>,..." lists the address of every rank.
+ * @param description transport and addresses
+ * @param rank index of this process, ignored with MPI
+ * @param size number of processes, ignored with MPI
+ * @return the transport, nullptr if the description is not valid
+ */
+std::unique_ptr<Transport> createTransport(const std::string &description, int rank, int size);
+
+/** Creates a transport with MPI, initializing it
+ * @return the transport, nullptr if the program was built without MPI
+ */
+std::unique_ptr<Transport> createMpiTransport();
+
+/** Creates the transport described by the environment of a process started as a rank
+ *  CONWAY_TRANSPORT holds the description given to createTransport, CONWAY_RANK and
+ *  CONWAY_RANKS the rank of the process and the number of processes.
+ * @return the transport, nullptr if CONWAY_TRANSPORT is not set or not valid
+ */
+std::unique_ptr<Transport> createTransportFromEnvironment();
@@ -1,6 +1,9 @@
 
 
 #include <ostream>
+#include <map>
+#include <memory>
+#include <random>
 
 /*imgui*/
 #include "backends/imgui_impl_glfw.h"
@@ -10,6 +13,27 @@
 /*opencl*/
 #include "opencl_conway.h"
 
+/*cpu engines*/
+#include "alloc_counter.h"
+#include "frame_arena.h"
+#include "engine.h"
+#include "sequential_conway.h"
+#include "rule_conway.h"
+#include "bitpacked_conway.h"
+#include "lut_conway.h"
+#include "simd_conway.h"
+#include "threaded_conway.h"
+#include "brick_conway.h"
+#include "hashlife_conway.h"
+#include "incremental_conway.h"
+#include "sparse_conway.h"
+#include "temporal_conway.h"
+#include "separable_conway.h"
+#include "ltl_conway.h"
+#include "padded_conway.h"
+#include "streaming_conway.h"
+#include "distributed_conway.h"
+
 /*glad/opengl*/
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -53,17 +77,63 @@ struct Controller{
     int current_fps = 10;           /* simulation fps, used as simulation velocity */
     bool running = 0;               /* if True, the simulation is running, otherwise is paused */
     int style_3d = 0;               /* if True a 3d style is used, its 2d*/
-    int parallel_simualtion = 1;    /* if True the next step of the simulations is calculated with OpenCL, other wise with a sequential function*/
+    int simulation_type = 1;        /* 0 calculates the next step with a sequential function, 1 with OpenCL, from 2 on with engines[simulation_type - 2]*/
+
+    /* rules */
+    LifeRule rules[2] = {conway_rule_2d, conway_rule_3d};   /* rule of the sequential simulation in 2D and 3D*/
+    char rule_text[2][64] = {"B3/S23", "B5/S45"};           /* text of the "Rule" field in 2D and 3D*/
+    bool rule_valid = true;                                 /* if False the text of the "Rule" field is not a rule*/
+
+    /* cpu engines */
+    std::vector<std::unique_ptr<Engine>> engines;   /* engines available in "Type of simulation", after Sequential and Parallel*/
+    std::vector<const char*> simulation_names;      /* names shown in "Type of simulation"*/
+    int loaded_engine = -1;                         /* index of the engine holding the world, -1 if none*/
+    int edited_engine = -1;                         /* index of the engine whose world was edited since its last step, it merges the edit instead of loading the world, -1 if none*/
+    float step_ms = 0;                              /* time taken by the last step, in milliseconds*/
+    size_t step_allocations = 0;                    /* heap allocations done by the last step*/
+    FrameArena frame_arena;                         /* scratch of the frame being drawn, released when the next one starts*/
+    size_t frame_allocations = 0;                   /* heap allocations done by the last whole frame*/
+    size_t frame_start_allocations = 0;             /* heap allocations done before the frame being drawn*/
+    BrickEngine *brick_engine;                      /* engine whose worker utilisation is shown, owned by engines*/
+    HashLifeEngine *hashlife_engine;                /* engine that jumps generations, owned by engines*/
+    int hashlife_jump = 0;                          /* log2 of the generations HashLife advances per step*/
+    int hashlife_memory_cap = 512;                  /* MB of nodes HashLife keeps before collecting garbage*/
+    IncrementalEngine *incremental_engine;          /* engine whose activity is shown, owned by engines*/
+    SparseEngine *sparse_engine;                    /* engine with an unbounded world, owned by engines*/
+    bool follow_pattern = true;                     /* if True the window of the unbounded world follows its live cells*/
+    TemporalEngine *temporal_engine;                /* engine that advances several generations per pass, owned by engines*/
+    int temporal_generations = 4;                   /* generations temporal blocking advances per step*/
+    LtlEngine *ltl_engine;                          /* engine for Larger than Life rules, owned by engines*/
+    LtlRule ltl_rules[2] = {bosco_rule, ltl_rule_3d};   /* Larger than Life rule in 2D and 3D*/
+    PaddedEngine *padded_engine;                    /* engine on a world with ghost cells, owned by engines*/
+    StreamingEngine *streaming_engine;              /* engine streaming the world from a file, owned by engines*/
+    DistributedEngine *distributed_engine = nullptr;    /* engine split across processes, owned by engines, only if the program was started as rank 0*/
 
     /* openCL variables */
     std::vector <int> next_state;   /* holds the next state in simulation, updated by OpenCL or sequential function*/
-    Queue q_3d;                     /* OpenCL queue */
+    std::vector <int> back_state;   /* buffer the sequential step writes to, then swapped with next_state */
+    std::vector <int> readback_state;   /* buffer the parallel step reads the device world into, then swapped with next_state */
+    std::map<int, Queue> queues;    /* OpenCL queue of every type of initConway, created the first time its kernel is selected */
+    int parallel_kernel = 0;        /* kernel of the parallel simulation, 0 per cell, 1 separable sums, 2 generated for the rule, 3 Larger than Life, 4 ghost cells, 5 every device */
+    int boundary = 0;               /* boundary of the generated kernel and ghost cells, 0 toroidal, 1 dead, 2 mirrored */
+    Queue *device_queue = nullptr;  /* queue whose device buffers hold the world, nullptr if next_state is newer */
+    int parallel_generations = 1;   /* generations the parallel simulation runs on the device per frame */
+    StepPipeline pipeline;          /* launches of the parallel simulation, bound again when its configuration changes */
+    std::unique_ptr<MultiDeviceWorld> multi_device; /* world split across every OpenCL device, created the first time it is used */
+    bool multi_device_loaded = false;   /* if True multi_device holds the world */
+
+    /* stable tiles */
+    TileTracker tiles;              /* tracks which tiles changed on the last step */
+    bool skip_stable_tiles = false; /* if True the sequential and parallel steps skip tiles that can't change */
+    int tiles_path = -1;            /* type of simulation of the last step done with tiles, -1 if the last step didn't use them */
 
     /* openGL uniforms */
     float cell_color[4] = {1, 1, 1, 1}; /* Color of cells */
     float sun_intensity = 1;            /* Intensity of directional Light*/
 
-    std::vector<float> lighted_cells_positions; /* Vector of positions of lighted cells*/
+    static const int max_light_cells = 20;      /* Most lighted cells, the size of the array in the shader*/
+    std::vector<float> lighted_cells_positions; /* Vector of positions of lighted cells, room for max_light_cells*/
+    std::mt19937 light_generator;               /* Picks the lighted cells*/
     int number_of_light_cells = 0;              /* Number of lighted cells according to Imgui*/
     int internal_number_of_light_cells = 0;     /* Actual number of lighted cells*/
     float light_cells_intensity = 1;            /* Intensity of cells light*/
@@ -78,11 +148,55 @@ struct Controller{
     Controller(int WIDTH, int HEIGHT);
 
 
+    /** Adds the engine split across the ranks of a transport to the types of simulation
+     * @param transport transport of rank 0, it must outlive the controller
+     */
+    void add_distributed_engine(Transport &transport);
+
+
     /* WORLD STATE FUNCTIONS */
 
+    /** Calculates the next state of the world with the type of simulation selected */
+    void step();
+
+    /** Starts a frame, releases the scratch of the last one and counts its heap allocations */
+    void begin_frame();
+
+    /** Returns true if the rule of the current dimensions is not the default one */
+    bool custom_rule();
+
+    /** Calculates the next state of the world with the selected engine,
+     * the world is loaded into the engine if it changed since the last step
+     */
+    void calculateStepWithEngine();
+
+    /** Marks the world as changed outside of the engines, they reload it on its next step */
+    void world_changed();
+
+    /** Marks the world as edited by hand, the engine that held it merges the edit on its next step
+     *  and keeps the cells it holds outside of the window
+     */
+    void world_edited();
+
+    /** Checks if an engine is the selected type of simulation and holds the world
+     * @param engine one of engines
+     */
+    bool engine_active(const Engine *engine);
+
     /** Calculates the next state of the world from the last state */
     void calculateStepSecuentially();
 
+    /** Calculates the next state of the world from the last state with OpenCL */
+    void calculateStepParallel();
+
+    /** Gets the OpenCL queue of a type of initConway, it is created the first time
+     * @param type 0 per cell, 3 stable tiles, 4 separable sums, 5 generated for the rule, 6 Larger than Life, 7 ghost cells
+     */
+    Queue &queue(int type);
+
+    /** Type of initConway of the kernel selected for the parallel simulation */
+    int parallel_type() const;
+
     /** Adds n gliders to the world on random positions
      * @param n number of gliders
      */
@@ -118,7 +232,7 @@ struct Controller{
      * @param M         amount of columns
      * @return          number of active cells after step
      */
-    int update_with_step(unsigned int &positions, std::vector<int> &result, std::vector<float> coords, int N, int M, int D);
+    int update_with_step(unsigned int &positions, const std::vector<int> &result, const std::vector<float> &coords, int N, int M, int D);
     
     /** Binds and loads a static buffer of floats
      * @param VBOS array of vertex buffer objects
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+/** Statistics of the memory mapped for worlds by WorldAllocator */
+struct WorldMemoryStats
+{
+    static const int max_nodes = 8;
+
+    size_t bytes = 0;                   /* bytes mapped for worlds */
+    size_t huge_bytes = 0;              /* bytes on explicit huge pages or backed by transparent ones, as reported by /proc/self/smaps */
+    size_t explicit_huge_bytes = 0;     /* bytes on explicit huge pages, a subset of huge_bytes */
+    size_t mappings = 0;                /* mappings alive */
+    size_t node_bytes[max_nodes] = {};  /* bytes first touched by a thread pinned to each node */
+    int nodes = 1;                      /* NUMA nodes of the machine */
+    int pinned_threads = 0;             /* threads pinned to a cpu */
+};
+
+/** Gets a snapshot of the statistics of the world memory */
+WorldMemoryStats worldMemoryStats();
+
+/** Number of NUMA nodes of the machine, 1 if it can't be read */
+int numaNodes();
+
+/** Gets the NUMA node of a cpu, 0 if it can't be read */
+int cpuNode(int cpu);
+
+/** Pins the calling thread to a cpu
+ * @param cpu index of the cpu
+ * @return false if the thread couldn't be pinned
+ */
+bool pinThread(int cpu);
+
+/** Records that a thread pinned to a node touched a range of a world first, so the kernel
+ *  placed its pages on that node
+ * @param memory start of the range, inside memory returned by mapWorld
+ * @param node node of the thread
+ * @param bytes size of the range
+ */
+void recordPlacement(const void *memory, int node, size_t bytes);
+
+/** Maps memory for a world, pages are placed when they are first touched
+ *  Worlds of 2 MB or more are aligned to 2 MB and use explicit huge pages when the system has
+ *  them reserved, transparent huge pages otherwise.
+ * @param bytes size of the world
+ * @return the memory, throws std::bad_alloc if it can't be mapped
+ */
+void *mapWorld(size_t bytes);
+
+/** Unmaps memory returned by mapWorld
+ * @param memory memory to unmap
+ * @param bytes size passed to mapWorld
+ */
+void unmapWorld(void *memory, size_t bytes);
+
+/** Allocates worlds with mapWorld, elements are default initialized so resizing doesn't touch
+ *  the pages: the threads that will step every part of the world should touch it first
+ * @tparam T type of the cells
+ */
+template <typename T>
+struct WorldAllocator
+{
+    typedef T value_type;
+
+    WorldAllocator() = default;
+
+    template <typename U>
+    WorldAllocator(const WorldAllocator<U> &) {}
+
+    T *allocate(size_t n) { return static_cast<T*>(mapWorld(n * sizeof(T))); }
+
+    void deallocate(T *memory, size_t n) { unmapWorld(memory, n * sizeof(T)); }
+
+    /** Leaves new cells as they are, mapped pages are already zero */
+    template <typename U>
+    void construct(U *cell) { ::new((void*)cell) U; }
+
+    template <typename U, typename... Args>
+    void construct(U *cell, Args&&... args) { ::new((void*)cell) U(std::forward<Args>(args)...); }
+
+    template <typename U>
+    bool operator==(const WorldAllocator<U> &) const { return true; }
+
+    template <typename U>
+    bool operator!=(const WorldAllocator<U> &) const { return false; }
+};
+
+/** World whose memory comes from WorldAllocator */
+template <typename T>
+using WorldVector = std::vector<T, WorldAllocator<T>>;
@@ -0,0 +1,236 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "alloc_counter.h"
+#include "frame_arena.h"
+#include "world_allocator.h"
+#include "sequential_conway.h"
+#include "rule_conway.h"
+#include "bitpacked_conway.h"
+#include "lut_conway.h"
+#include "simd_conway.h"
+#include "threaded_conway.h"
+#include "brick_conway.h"
+#include "incremental_conway.h"
+#include "temporal_conway.h"
+#include "separable_conway.h"
+#include "ltl_conway.h"
+#include "padded_conway.h"
+#include "streaming_conway.h"
+
+/* Runs every CPU engine on the same random world, reports its speed and the heap
+ * allocations it does per step after the first one, and checks its result against
+ * the sequential step. Small worlds with sizes the engines handle apart, like rows of
+ * 64*k+1 columns or a single row, are checked too, and so are frames of the window, which
+ * must not allocate once their scratch has grown. The exit code is 1 if any engine differs
+ * from the sequential step or allocates after its first step, or if a frame allocates.
+ *
+ * usage: conway_benchmark [rows] [cols] [planes] [generations] [3d]
+ * generations should be a multiple of 4, the generations per step of temporal blocking
+ */
+
+/** Wraps the sequential step as an engine, used as reference */
+class SequentialEngine : public Engine
+{
+protected:
+    int _N, _M, _D;
+    std::vector<int> _current, _next;
+
+public:
+    const char *name() const override { return "Sequential"; }
+    bool supports_3d() const override { return true; }
+
+    void load(const std::vector<int> &world, int N, int M, int D) override {
+        _N = N, _M = M, _D = D;
+        _current = world;
+        _next.resize(world.size());
+    }
+
+    void step(int flag_3d) override {
+        calculateStepSequential(_current.data(), _next.data(), _N, _M, _D, flag_3d);
+        _current.swap(_next);
+    }
+
+    void store(std::vector<int> &world) override { world = _current; }
+};
+
+/** Wraps the step specialized for the default rules as an engine */
+class RuleEngine : public SequentialEngine
+{
+public:
+    const char *name() const override { return "Specialized rule"; }
+
+    void step(int flag_3d) override {
+        calculateStepRule(_current.data(), _next.data(), _N, _M, _D, flag_3d ? conway_rule_3d : conway_rule_2d, flag_3d);
+        _current.swap(_next);
+    }
+};
+
+/** Runs every engine on a world, compares it with the first one, the sequential step, and
+ *  checks it doesn't allocate once its first step sized its scratch
+ * @param engines engines to run
+ * @param world initial world
+ * @param generations generations to run
+ * @param flag_3d 1 for the 3D rule
+ * @param report prints the speed of every engine, otherwise only the engines that fail
+ * @return number of engines whose result differs from the sequential step or that allocated
+ */
+static int runEngines(std::vector<std::unique_ptr<Engine>> &engines, const std::vector<int> &world, int N, int M, int D, int generations, int flag_3d, bool report){
+    std::vector<int> reference, result(world.size());
+    int failures = 0;
+    for(auto &engine : engines){
+        if(flag_3d && !engine->supports_3d()) continue;
+
+        // engines advancing several generations per step need a multiple of them
+        int per_step = engine->generationsPerStep();
+        if(generations % per_step){
+            if(report) std::cout << engine->name() << ": skipped, advances " << per_step << " generations per step" << std::endl;
+            continue;
+        }
+
+        engine->load(world, N, M, D);
+        auto start = std::chrono::steady_clock::now();
+        size_t allocations = 0;
+        for(int g = 0; g < generations; g += per_step){
+            // the first step may size the scratch of the engine
+            size_t before = allocationCount();
+            engine->step(flag_3d);
+            if(g) allocations += allocationCount() - before;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        engine->store(result);
+
+        if(reference.empty()) reference = result;
+        bool matches = result == reference;
+        if(!matches || allocations) failures++;
+
+        if(report){
+            double cells_per_second = (double)world.size() * generations / elapsed.count();
+            std::cout << engine->name() << ": " << elapsed.count() * 1000 / generations << " ms/generation, "
+                      << cells_per_second / 1e6 << " Mcells/s, "
+                      << allocations << " allocations after the first step, "
+                      << (matches ? "matches" : "DIFFERS FROM") << " sequential" << std::endl;
+        }
+        else if(!matches || allocations){
+            std::cout << engine->name() << ": " << (matches ? "" : "DIFFERS FROM sequential, ") << allocations
+                      << " allocations after the first step on " << N << "x" << M << "x" << D << (flag_3d ? " 3D" : " 2D") << std::endl;
+        }
+    }
+    return failures;
+}
+
+/** Runs frames of the window on an engine: the arena of the frame is reset, the engine steps, the
+ *  world is stored and the positions of its live cells are gathered in the arena. The first two
+ *  frames grow the arena and the scratch of the engine, the ones after them must not allocate
+ * @param engine engine to run
+ * @param world initial world
+ * @param flag_3d 1 for the 3D rule
+ * @return number of frames that allocated after the first two
+ */
+static int checkFrames(Engine &engine, const std::vector<int> &world, int N, int M, int D, int flag_3d){
+    std::vector<float> coords(world.size() * 3);
+    for(size_t i = 0; i < coords.size(); i++) coords[i] = (float)i;
+    std::vector<int> shown(world.size());
+
+    // smaller than a frame, so the first one overflows and the arena grows
+    FrameArena arena(4096);
+    engine.load(world, N, M, D);
+    int allocating = 0;
+    for(int frame = 0; frame < 6; frame++){
+        size_t before = allocationCount();
+        arena.reset();
+        engine.step(flag_3d);
+        engine.store(shown);
+        std::pmr::vector<float> positions(&arena);
+        gatherLiveCells(shown, coords, shown.size(), positions);
+        size_t allocations = allocationCount() - before;
+
+        if(frame >= 2 && allocations){
+            std::cout << engine.name() << ": frame " << frame << " did " << allocations << " allocations on "
+                      << N << "x" << M << "x" << D << (flag_3d ? " 3D" : " 2D") << std::endl;
+            allocating++;
+        }
+    }
+    return allocating;
+}
+
+/** Fills a world of the given size with random cells */
+static std::vector<int> randomWorld(int N, int M, int D, std::mt19937 &gen){
+    std::vector<int> world((size_t)N * M * D);
+    std::bernoulli_distribution alive(0.3);
+    for(auto &cell : world) cell = alive(gen);
+    return world;
+}
+
+int main(int argc, char **argv){
+    int N = argc > 1 ? std::atoi(argv[1]) : 2048;
+    int M = argc > 2 ? std::atoi(argv[2]) : 2048;
+    int D = argc > 3 ? std::atoi(argv[3]) : 1;
+    int generations = argc > 4 ? std::atoi(argv[4]) : 8;
+    int flag_3d = argc > 5 ? std::atoi(argv[5]) : 0;
+
+    std::mt19937 gen(42);
+    std::vector<int> world = randomWorld(N, M, D, gen);
+
+    std::vector<std::unique_ptr<Engine>> engines;
+    engines.emplace_back(new SequentialEngine());
+    engines.emplace_back(new RuleEngine());
+    engines.emplace_back(new BitPackedEngine());
+    engines.emplace_back(new LutEngine());
+    engines.emplace_back(new SimdEngine());
+    engines.emplace_back(new ThreadedEngine());
+    engines.emplace_back(new BrickEngine());
+    engines.emplace_back(new IncrementalEngine());
+    engines.emplace_back(new TemporalEngine(4));
+    engines.emplace_back(new SeparableEngine());
+    engines.emplace_back(new PaddedEngine());
+    engines.emplace_back(new StreamingEngine());
+
+    // with radius 1 Larger than Life runs the rules of the simulation, its cost doesn't change with the radius
+    LtlEngine *ltl = new LtlEngine();
+    ltl->setRule({1, 3, 3, 2, 3, false}, 0);
+    ltl->setRule({1, 5, 5, 4, 5, false}, 1);
+    engines.emplace_back(ltl);
+
+    std::cout << "World " << N << "x" << M << "x" << D << ", " << generations << " generations, "
+              << (flag_3d ? "3D" : "2D") << " rule" << std::endl;
+    int failures = runEngines(engines, world, N, M, D, generations, flag_3d, true);
+    if(failures) std::cout << failures << " engines differ from sequential or allocate after their first step" << std::endl;
+    int edge_failures = 0;
+
+    // edges of the packed and tiled engines: a last word with a single column, single rows and columns
+    const int sizes[][2] = {{64, 65}, {64, 129}, {64, 193}, {63, 127}, {1, 64}, {1, 65}, {64, 1}, {1, 1}, {2, 2}, {3, 3}};
+    for(auto &size : sizes){
+        for(int check_3d = 0; check_3d <= 1; check_3d++){
+            int planes = check_3d ? 3 : 1;
+            std::vector<int> small = randomWorld(size[0], size[1], planes, gen);
+            edge_failures += runEngines(engines, small, size[0], size[1], planes, 8, check_3d, false);
+        }
+    }
+    std::cout << "Edge sizes: " << (edge_failures ? "some engines FAIL" : "every engine matches sequential without allocating") << std::endl;
+    failures += edge_failures;
+
+    // frames of the window, with the scratch in the arena of the frame
+    int frame_failures = 0;
+    for(int check_3d = 0; check_3d <= 1; check_3d++){
+        int side = check_3d ? 32 : 128, planes = check_3d ? 32 : 1;
+        std::vector<int> small = randomWorld(side, side, planes, gen);
+        for(auto &engine : engines){
+            if(check_3d && !engine->supports_3d()) continue;
+            frame_failures += checkFrames(*engine, small, side, side, planes, check_3d);
+        }
+    }
+    std::cout << "Frames: " << (frame_failures ? "some frames ALLOCATE" : "no allocations once the scratch has grown") << std::endl;
+    failures += frame_failures;
+
+    WorldMemoryStats memory = worldMemoryStats();
+    std::cout << "World memory: " << memory.bytes / 1048576.0 << " MB in " << memory.mappings << " mappings, "
+              << memory.huge_bytes / 1048576.0 << " MB on huge pages, " << memory.nodes << " NUMA nodes, "
+              << memory.pinned_threads << " threads pinned" << std::endl;
+    return failures ? 1 : 0;
+}
@@ -13,9 +13,16 @@ const int WIDTH = 1000, HEIGHT = 1000;
 
 int main()
 {
+    /* Distributed mode, the ranks but 0 only calculate their slab of the world */
+    std::unique_ptr<Transport> transport = createTransportFromEnvironment();
+    if(transport && transport->rank() != 0){
+        DistributedEngine(*transport).serve();
+        return 0;
+    }
 
     /* Controller */
     Controller controller = Controller(WIDTH, HEIGHT);
+    if(transport) controller.add_distributed_engine(*transport);
 
     /* Window */
     Window window = Window(controller);
@@ -148,6 +155,7 @@ int main()
     
     /*Rendering function*/
     auto render = [&](){
+        controller.begin_frame();
 
         /*background color*/
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -189,8 +197,7 @@ int main()
         /*if not in pause*/
         if(controller.running){
             /*Calculating conway step*/
-            if(controller.parallel_simualtion) calculateStep(controller.rows, controller.cols, controller.planes, controller.q_3d, controller.next_state, controller.style_3d == 1);
-            else controller.calculateStepSecuentially();
+            controller.step();
         }
         
         /*updates the positions buffer and gets the number of active cells*/
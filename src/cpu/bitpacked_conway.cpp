@@ -0,0 +1,98 @@
+#include "bitpacked_conway.h"
+
+/** Gets the word of western neighbours (column - 1) of a word in a row, wrapping around
+ * @param row packed row
+ * @param w index of the word
+ * @param words words per row
+ * @param last bit position of the last column in the last word
+ */
+static inline uint64_t westOf(const uint64_t *row, int w, int words, int last){
+    uint64_t carry = w > 0 ? row[w - 1] >> 63 : (row[words - 1] >> last) & 1;
+    return (row[w] << 1) | carry;
+}
+
+/** Gets the word of eastern neighbours (column + 1) of a word in a row, wrapping around
+ * @param row packed row
+ * @param w index of the word
+ * @param words words per row
+ * @param last bit position of the last column in the last word
+ */
+static inline uint64_t eastOf(const uint64_t *row, int w, int words, int last){
+    uint64_t carry = w < words - 1 ? row[w + 1] << 63 : (row[0] & 1) << last;
+    return (row[w] >> 1) | carry;
+}
+
+void BitPackedEngine::load(const std::vector<int> &world, int N, int M, int D){
+    _N = N, _M = M, _D = D;
+    _words = (M + 63) / 64;
+    _last_mask = M % 64 ? (uint64_t(1) << (M % 64)) - 1 : ~uint64_t(0);
+
+    _current.assign((size_t)_words * N * D, 0);
+    _next.assign(_current.size(), 0);
+
+    for(int k = 0; k < D; k++){
+        for(int i = 0; i < N; i++){
+            uint64_t *row = &_current[((size_t)k * N + i) * _words];
+            const int *cells = &world[((size_t)k * N + i) * M];
+            for(int j = 0; j < M; j++){
+                if(cells[j]) row[j / 64] |= uint64_t(1) << (j % 64);
+            }
+        }
+    }
+}
+
+void BitPackedEngine::stepRow(const uint64_t *up, const uint64_t *row, const uint64_t *down, uint64_t *out) const{
+    const int last = (_M - 1) % 64;
+
+    for(int w = 0; w < _words; w++){
+        // sum of the three cells above, two bits
+        uint64_t l = westOf(up, w, _words, last), m = up[w], r = eastOf(up, w, _words, last);
+        uint64_t a0 = l ^ m ^ r, a1 = (l & m) | (r & (l ^ m));
+
+        // sum of the two side cells, two bits
+        l = westOf(row, w, _words, last), r = eastOf(row, w, _words, last);
+        uint64_t b0 = l ^ r, b1 = l & r;
+
+        // sum of the three cells below, two bits
+        l = westOf(down, w, _words, last), m = down[w], r = eastOf(down, w, _words, last);
+        uint64_t c0 = l ^ m ^ r, c1 = (l & m) | (r & (l ^ m));
+
+        // a + b, three bits
+        uint64_t x0 = a0 ^ b0, k0 = a0 & b0;
+        uint64_t x1 = a1 ^ b1 ^ k0, x2 = (a1 & b1) | (k0 & (a1 ^ b1));
+
+        // (a + b) + c, bits over the second one are only checked for being set
+        uint64_t y0 = x0 ^ c0, q0 = x0 & c0;
+        uint64_t y1 = x1 ^ c1 ^ q0, q1 = (x1 & c1) | (q0 & (x1 ^ c1));
+        uint64_t four_or_more = x2 | q1;
+
+        // alive with 3 neighbours, or with 2 if it was already alive
+        out[w] = y1 & ~four_or_more & (y0 | row[w]);
+    }
+    out[_words - 1] &= _last_mask;
+}
+
+void BitPackedEngine::step(int){
+    for(int k = 0; k < _D; k++){
+        const uint64_t *plane = &_current[(size_t)k * _N * _words];
+        uint64_t *out = &_next[(size_t)k * _N * _words];
+        for(int i = 0; i < _N; i++){
+            // rows only wrap at the edges of the plane
+            int up = i == 0 ? _N - 1 : i - 1, down = i == _N - 1 ? 0 : i + 1;
+            stepRow(plane + (size_t)up * _words, plane + (size_t)i * _words, plane + (size_t)down * _words, out + (size_t)i * _words);
+        }
+    }
+    _current.swap(_next);
+}
+
+void BitPackedEngine::store(std::vector<int> &world){
+    for(int k = 0; k < _D; k++){
+        for(int i = 0; i < _N; i++){
+            const uint64_t *row = &_current[((size_t)k * _N + i) * _words];
+            int *cells = &world[((size_t)k * _N + i) * _M];
+            for(int j = 0; j < _M; j++){
+                cells[j] = (row[j / 64] >> (j % 64)) & 1;
+            }
+        }
+    }
+}
@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <chrono>
+
+#include "brick_conway.h"
+
+void WorkDeque::reset(int capacity){
+    _items.resize(capacity);
+    _head = _tail = 0;
+}
+
+bool WorkDeque::pop(int &item){
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(_head == _tail) return false;
+    item = _items[--_tail];
+    return true;
+}
+
+bool WorkDeque::steal(int &item){
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(_head == _tail) return false;
+    item = _items[_head++];
+    return true;
+}
+
+/** Fills the coordinates before and after every coordinate of an axis, wrapping around */
+static void wrappedNeighbours(std::vector<int> &prev, std::vector<int> &next, int size){
+    prev.resize(size), next.resize(size);
+    for(int x = 0; x < size; x++){
+        prev[x] = x == 0 ? size - 1 : x - 1;
+        next[x] = x == size - 1 ? 0 : x + 1;
+    }
+}
+
+BrickEngine::BrickEngine(int workers) : _pool(std::max(workers, 1)), _deques(_pool.size()), _stats(_pool.size()) {}
+
+void BrickEngine::load(const std::vector<int> &world, int N, int M, int D){
+    _N = N, _M = M, _D = D;
+    _bricks_i = (N + BRICK - 1) / BRICK, _bricks_j = (M + BRICK - 1) / BRICK, _bricks_k = (D + BRICK - 1) / BRICK;
+
+    _current.assign(world.begin(), world.begin() + (size_t)N * M * D);
+    _next.assign(_current.size(), 0);
+
+    wrappedNeighbours(_prev_i, _next_i, N);
+    wrappedNeighbours(_prev_j, _next_j, M);
+    wrappedNeighbours(_prev_k, _next_k, D);
+
+    _occupied.resize(totalBricks());
+    _next_occupied.assign(totalBricks(), 0);
+    _active.resize(totalBricks());
+    for(int b = 0; b < totalBricks(); b++) _occupied[b] = brickOccupied(_current, b);
+
+    for(auto &deque : _deques) deque.reset(totalBricks());
+}
+
+bool BrickEngine::brickOccupied(const std::vector<uint8_t> &world, int brick) const{
+    int bk = brick / (_bricks_i * _bricks_j), bi = (brick / _bricks_j) % _bricks_i, bj = brick % _bricks_j;
+    int j0 = bj * BRICK, j1 = std::min(j0 + BRICK, _M);
+    for(int k = bk * BRICK; k < std::min((bk + 1) * BRICK, _D); k++){
+        for(int i = bi * BRICK; i < std::min((bi + 1) * BRICK, _N); i++){
+            const uint8_t *row = &world[((size_t)k * _N + i) * _M];
+            if(std::any_of(row + j0, row + j1, [](uint8_t cell){ return cell; })) return true;
+        }
+    }
+    return false;
+}
+
+bool BrickEngine::stepBrick(int brick, int flag_3d){
+    int bk = brick / (_bricks_i * _bricks_j), bi = (brick / _bricks_j) % _bricks_i, bj = brick % _bricks_j;
+    int j0 = bj * BRICK, j1 = std::min(j0 + BRICK, _M);
+    const uint8_t target = flag_3d ? 5 : 3;
+    uint8_t alive = 0;
+
+    for(int k = bk * BRICK; k < std::min((bk + 1) * BRICK, _D); k++){
+        // with the 2D rule only the plane of the cell is used
+        int planes[3] = {k, _prev_k[k], _next_k[k]};
+        int planes_used = flag_3d ? 3 : 1;
+
+        for(int i = bi * BRICK; i < std::min((bi + 1) * BRICK, _N); i++){
+            const uint8_t *rows[9];
+            for(int p = 0; p < planes_used; p++){
+                rows[p * 3] = &_current[((size_t)planes[p] * _N + _prev_i[i]) * _M];
+                rows[p * 3 + 1] = &_current[((size_t)planes[p] * _N + i) * _M];
+                rows[p * 3 + 2] = &_current[((size_t)planes[p] * _N + _next_i[i]) * _M];
+            }
+            const uint8_t *center = rows[1];
+            uint8_t *out = &_next[((size_t)k * _N + i) * _M];
+
+            for(int j = j0; j < j1; j++){
+                int jp = _prev_j[j], jn = _next_j[j];
+                uint8_t n = 0;
+                for(int r = 0; r < planes_used * 3; r++) n += rows[r][jp] + rows[r][j] + rows[r][jn];
+                n -= center[j];
+                out[j] = (n | center[j]) == target;
+                alive |= out[j];
+            }
+        }
+    }
+    return alive;
+}
+
+void BrickEngine::clearBrick(int brick){
+    int bk = brick / (_bricks_i * _bricks_j), bi = (brick / _bricks_j) % _bricks_i, bj = brick % _bricks_j;
+    int j0 = bj * BRICK, j1 = std::min(j0 + BRICK, _M);
+    for(int k = bk * BRICK; k < std::min((bk + 1) * BRICK, _D); k++){
+        for(int i = bi * BRICK; i < std::min((bi + 1) * BRICK, _N); i++){
+            uint8_t *row = &_next[((size_t)k * _N + i) * _M];
+            std::fill(row + j0, row + j1, 0);
+        }
+    }
+}
+
+void BrickEngine::step(int flag_3d){
+    const int workers = _pool.size();
+
+    // a brick is calculated if it or any of its 26 neighbours has live cells,
+    // skipped bricks that still hold old cells in _next are cleared
+    _active_bricks = 0;
+    for(int bk = 0; bk < _bricks_k; bk++){
+        for(int bi = 0; bi < _bricks_i; bi++){
+            for(int bj = 0; bj < _bricks_j; bj++){
+                int brick = (bk * _bricks_i + bi) * _bricks_j + bj;
+                bool active = false;
+                for(int dk = -1; dk <= 1 && !active; dk++){
+                    for(int di = -1; di <= 1 && !active; di++){
+                        for(int dj = -1; dj <= 1 && !active; dj++){
+                            int nk = (bk + dk + _bricks_k) % _bricks_k, ni = (bi + di + _bricks_i) % _bricks_i, nj = (bj + dj + _bricks_j) % _bricks_j;
+                            active = _occupied[(nk * _bricks_i + ni) * _bricks_j + nj];
+                        }
+                    }
+                }
+                _active[brick] = active;
+                _active_bricks += active;
+
+                // contiguous runs of bricks go to the same worker, keeping neighbours together
+                if(active || _next_occupied[brick]){
+                    _deques[(long long)brick * workers / totalBricks()].push(brick);
+                }
+            }
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    _pool.run([&](int worker){
+        WorkerStats &stats = _stats[worker];
+        stats.busy = 0, stats.bricks = 0, stats.steals = 0;
+
+        int brick;
+        while(true){
+            bool found = _deques[worker].pop(brick);
+            for(int w = 1; w < workers && !found; w++){
+                found = _deques[(worker + w) % workers].steal(brick);
+                stats.steals += found;
+            }
+            if(!found) break;
+
+            auto brick_start = std::chrono::steady_clock::now();
+            if(_active[brick]){
+                _next_occupied[brick] = stepBrick(brick, flag_3d);
+                stats.bricks++;
+            }
+            else{
+                clearBrick(brick);
+                _next_occupied[brick] = 0;
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - brick_start;
+            stats.busy += elapsed.count();
+        }
+    });
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    for(auto &stats : _stats) stats.utilisation = elapsed.count() > 0 ? stats.busy / elapsed.count() : 0;
+    for(auto &deque : _deques) deque.reset(totalBricks());
+
+    _current.swap(_next);
+    _occupied.swap(_next_occupied);
+}
+
+void BrickEngine::store(std::vector<int> &world){
+    std::copy(_current.begin(), _current.end(), world.begin());
+}
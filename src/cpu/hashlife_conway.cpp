@@ -0,0 +1,308 @@
+#include <algorithm>
+
+#include "hashlife_conway.h"
+
+/** Hash of the children of a node */
+static inline size_t hashChildren(int nw, int ne, int sw, int se){
+    uint64_t h = (uint64_t)nw * 0x9E3779B97F4A7C15ull;
+    h = (h ^ (uint64_t)ne) * 0xBF58476D1CE4E5B9ull;
+    h = (h ^ (uint64_t)sw) * 0x94D049BB133111EBull;
+    h = (h ^ (uint64_t)se) * 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 31);
+}
+
+HashLifeEngine::HashLifeEngine(size_t memory_cap) : _memory_cap(memory_cap) {}
+
+int HashLifeEngine::join(int nw, int ne, int sw, int se){
+    size_t mask = _buckets.size() - 1;
+    size_t bucket = hashChildren(nw, ne, sw, se) & mask;
+    for(int n = _buckets[bucket]; n != -1; n = _nodes[n].next){
+        const Node &node = _nodes[n];
+        if(node.nw == nw && node.ne == ne && node.sw == sw && node.se == se) return n;
+    }
+
+    Node node;
+    node.nw = nw, node.ne = ne, node.sw = sw, node.se = se;
+    node.level = _nodes[nw].level + 1;
+    node.result = -1, node.result_step = -1;
+    node.population = _nodes[nw].population + _nodes[ne].population + _nodes[sw].population + _nodes[se].population;
+    node.next = _buckets[bucket];
+    _nodes.push_back(node);
+    _buckets[bucket] = _nodes.size() - 1;
+
+    if(_nodes.size() > _buckets.size()) rehash(_buckets.size() * 2);
+    return _nodes.size() - 1;
+}
+
+void HashLifeEngine::rehash(size_t buckets){
+    _buckets.assign(buckets, -1);
+    for(int n = 2; n < (int)_nodes.size(); n++){
+        Node &node = _nodes[n];
+        size_t bucket = hashChildren(node.nw, node.ne, node.sw, node.se) & (buckets - 1);
+        node.next = _buckets[bucket];
+        _buckets[bucket] = n;
+    }
+}
+
+int HashLifeEngine::emptyNode(int level){
+    while((int)_empty.size() <= level){
+        int child = _empty.back();
+        _empty.push_back(join(child, child, child, child));
+    }
+    return _empty[level];
+}
+
+int HashLifeEngine::expand(int node){
+    Node n = _nodes[node];
+    int e = emptyNode(n.level - 1);
+    return join(join(e, e, e, n.nw), join(e, e, n.ne, e),
+                join(e, n.sw, e, e), join(n.se, e, e, e));
+}
+
+bool HashLifeEngine::centered(int node) const{
+    const Node &n = _nodes[node];
+    auto greatGrandchild = [&](int child, int first, int second){
+        const Node &c = _nodes[child];
+        const int g = first == 0 ? c.nw : first == 1 ? c.ne : first == 2 ? c.sw : c.se;
+        const Node &gc = _nodes[g];
+        return _nodes[second == 0 ? gc.nw : second == 1 ? gc.ne : second == 2 ? gc.sw : gc.se].population;
+    };
+    // the innermost great-grandchild of every child is S/8 wide, the four of them make the
+    // square of side S/4 on the center of a node S cells wide
+    uint64_t center = greatGrandchild(n.nw, 3, 3) + greatGrandchild(n.ne, 2, 2) + greatGrandchild(n.sw, 1, 1) + greatGrandchild(n.se, 0, 0);
+    return center == n.population;
+}
+
+int HashLifeEngine::life4x4(int node){
+    // cells of the 4x4 square, row major
+    int cells[4][4];
+    const Node &n = _nodes[node];
+    int children[4] = {n.nw, n.ne, n.sw, n.se};
+    for(int c = 0; c < 4; c++){
+        const Node &child = _nodes[children[c]];
+        int i = (c / 2) * 2, j = (c % 2) * 2;
+        cells[i][j] = child.nw, cells[i][j + 1] = child.ne;
+        cells[i + 1][j] = child.sw, cells[i + 1][j + 1] = child.se;
+    }
+
+    int next[2][2];
+    for(int i = 1; i <= 2; i++){
+        for(int j = 1; j <= 2; j++){
+            int neighbours = 0;
+            for(int di = -1; di <= 1; di++){
+                for(int dj = -1; dj <= 1; dj++){
+                    if(di || dj) neighbours += cells[i + di][j + dj];
+                }
+            }
+            next[i - 1][j - 1] = neighbours == 3 || (neighbours == 2 && cells[i][j]);
+        }
+    }
+    return join(next[0][0], next[0][1], next[1][0], next[1][1]);
+}
+
+int HashLifeEngine::successor(int node, int j){
+    Node m = _nodes[node];
+    j = std::min(j, m.level - 2);
+
+    if(m.population == 0) return emptyNode(m.level - 1);
+    if(m.result != -1 && m.result_step == j) return m.result;
+
+    int result;
+    if(m.level == 2){
+        result = life4x4(node);
+    }
+    else{
+        Node a = _nodes[m.nw], b = _nodes[m.ne], c = _nodes[m.sw], d = _nodes[m.se];
+
+        // nine overlapping subsquares of half the size, advanced 2^j generations
+        // (or half of it when the second pass below advances the rest)
+        int c1 = successor(join(a.nw, a.ne, a.sw, a.se), j);
+        int c2 = successor(join(a.ne, b.nw, a.se, b.sw), j);
+        int c3 = successor(join(b.nw, b.ne, b.sw, b.se), j);
+        int c4 = successor(join(a.sw, a.se, c.nw, c.ne), j);
+        int c5 = successor(join(a.se, b.sw, c.ne, d.nw), j);
+        int c6 = successor(join(b.sw, b.se, d.nw, d.ne), j);
+        int c7 = successor(join(c.nw, c.ne, c.sw, c.se), j);
+        int c8 = successor(join(c.ne, d.nw, c.se, d.sw), j);
+        int c9 = successor(join(d.nw, d.ne, d.sw, d.se), j);
+
+        if(j < m.level - 2){
+            // the subsquares already advanced 2^j, only their centers are joined
+            auto center = [&](int q1, int q2, int q3, int q4){
+                return join(_nodes[q1].se, _nodes[q2].sw, _nodes[q3].ne, _nodes[q4].nw);
+            };
+            int nw = center(c1, c2, c4, c5), ne = center(c2, c3, c5, c6);
+            int sw = center(c4, c5, c7, c8), se = center(c5, c6, c8, c9);
+            result = join(nw, ne, sw, se);
+        }
+        else{
+            int nw = successor(join(c1, c2, c4, c5), j);
+            int ne = successor(join(c2, c3, c5, c6), j);
+            int sw = successor(join(c4, c5, c7, c8), j);
+            int se = successor(join(c5, c6, c8, c9), j);
+            result = join(nw, ne, sw, se);
+        }
+    }
+
+    _nodes[node].result = result;
+    _nodes[node].result_step = j;
+    return result;
+}
+
+int HashLifeEngine::build(const std::vector<int> &world, int plane, int level, long long y0, long long x0){
+    // window of the dense world, relative to the origin
+    long long top = -(_N / 2), left = -(_M / 2);
+    long long size = 1ll << level;
+    if(y0 + size <= top || y0 >= top + _N || x0 + size <= left || x0 >= left + _M) return emptyNode(level);
+
+    if(level == 0) return world[((size_t)plane * _N + (y0 - top)) * _M + (x0 - left)] ? 1 : 0;
+
+    long long half = size / 2;
+    int nw = build(world, plane, level - 1, y0, x0);
+    int ne = build(world, plane, level - 1, y0, x0 + half);
+    int sw = build(world, plane, level - 1, y0 + half, x0);
+    int se = build(world, plane, level - 1, y0 + half, x0 + half);
+    return join(nw, ne, sw, se);
+}
+
+void HashLifeEngine::write(std::vector<int> &world, int plane, int node, long long y0, long long x0) const{
+    const Node &n = _nodes[node];
+    long long top = -(_N / 2), left = -(_M / 2);
+    long long size = 1ll << n.level;
+    if(n.population == 0 || y0 + size <= top || y0 >= top + _N || x0 + size <= left || x0 >= left + _M) return;
+
+    if(n.level == 0){
+        world[((size_t)plane * _N + (y0 - top)) * _M + (x0 - left)] = 1;
+        return;
+    }
+
+    long long half = size / 2;
+    write(world, plane, n.nw, y0, x0);
+    write(world, plane, n.ne, y0, x0 + half);
+    write(world, plane, n.sw, y0 + half, x0);
+    write(world, plane, n.se, y0 + half, x0 + half);
+}
+
+void HashLifeEngine::load(const std::vector<int> &world, int N, int M, int D){
+    _N = N, _M = M, _D = D;
+    _generation = 0, _collections = 0;
+
+    // the two cells, their children are never read
+    _nodes.clear();
+    _nodes.push_back({-1, -1, -1, -1, 0, -1, -1, -1, 0});
+    _nodes.push_back({-1, -1, -1, -1, 0, -1, -1, -1, 1});
+    _buckets.assign(1 << 16, -1);
+    _empty.assign(1, 0);
+
+    int level = windowLevel();
+    _roots.resize(D);
+    for(int k = 0; k < D; k++){
+        _roots[k] = build(world, k, level, -(1ll << (level - 1)), -(1ll << (level - 1)));
+    }
+}
+
+int HashLifeEngine::windowLevel() const{
+    // smallest root holding the window, at least 4x4
+    int level = 2;
+    while((1ll << (level - 1)) < std::max(_N, _M)) level++;
+    return level;
+}
+
+int HashLifeEngine::merge(const std::vector<int> &world, int plane, int node, long long y0, long long x0){
+    long long top = -(_N / 2), left = -(_M / 2);
+    Node n = _nodes[node];
+    long long size = 1ll << n.level;
+    if(y0 + size <= top || y0 >= top + _N || x0 + size <= left || x0 >= left + _M) return node;
+
+    if(n.level == 0) return world[((size_t)plane * _N + (y0 - top)) * _M + (x0 - left)] ? 1 : 0;
+
+    long long half = size / 2;
+    int nw = merge(world, plane, n.nw, y0, x0);
+    int ne = merge(world, plane, n.ne, y0, x0 + half);
+    int sw = merge(world, plane, n.sw, y0 + half, x0);
+    int se = merge(world, plane, n.se, y0 + half, x0 + half);
+    return join(nw, ne, sw, se);
+}
+
+void HashLifeEngine::edit(const std::vector<int> &world, int N, int M, int D){
+    if(N != _N || M != _M || D != _D || _roots.size() != (size_t)D){
+        load(world, N, M, D);
+        return;
+    }
+
+    // roots shrink by a level on every step, they grow back to hold the window
+    int level = windowLevel();
+    for(int k = 0; k < D; k++){
+        int &root = _roots[k];
+        while(_nodes[root].level < level) root = expand(root);
+        long long half = 1ll << (_nodes[root].level - 1);
+        root = merge(world, k, root, -half, -half);
+    }
+}
+
+void HashLifeEngine::step(int){
+    for(int &root : _roots){
+        if(_nodes[root].population == 0) continue;
+
+        // with a root S >= 2^(jump+3) cells wide the jump is at most S/8 generations, cells on its
+        // center S/4 square stay inside the center S/2 square the successor returns
+        while(_nodes[root].level < _jump + 3 || !centered(root)) root = expand(root);
+        root = successor(root, _jump);
+    }
+    _generation += uint64_t(1) << _jump;
+
+    if(_nodes.size() * sizeof(Node) > _memory_cap) collect();
+}
+
+void HashLifeEngine::store(std::vector<int> &world){
+    std::fill(world.begin(), world.begin() + (size_t)_N * _M * _D, 0);
+    for(int k = 0; k < _D; k++){
+        int level = _nodes[_roots[k]].level;
+        write(world, k, _roots[k], -(1ll << (level - 1)), -(1ll << (level - 1)));
+    }
+}
+
+void HashLifeEngine::collect(){
+    std::vector<char> marked(_nodes.size(), 0);
+    std::vector<int> stack(_roots.begin(), _roots.end());
+    stack.insert(stack.end(), _empty.begin(), _empty.end());
+    marked[0] = marked[1] = 1;
+
+    while(!stack.empty()){
+        int n = stack.back();
+        stack.pop_back();
+        if(marked[n]) continue;
+        marked[n] = 1;
+        const Node &node = _nodes[n];
+        stack.insert(stack.end(), {node.nw, node.ne, node.sw, node.se});
+    }
+
+    // children are always created before their parents, so one pass remaps them
+    std::vector<int> remap(_nodes.size(), -1);
+    int count = 0;
+    for(int n = 0; n < (int)_nodes.size(); n++){
+        if(!marked[n]) continue;
+        Node node = _nodes[n];
+        if(node.level > 0){
+            node.nw = remap[node.nw], node.ne = remap[node.ne];
+            node.sw = remap[node.sw], node.se = remap[node.se];
+        }
+        remap[n] = count;
+        _nodes[count++] = node;
+    }
+    _nodes.resize(count);
+
+    // results are kept only when they survived
+    for(Node &node : _nodes){
+        if(node.result != -1) node.result = remap[node.result];
+        if(node.result == -1) node.result_step = -1;
+    }
+
+    for(int &root : _roots) root = remap[root];
+    for(int &empty : _empty) empty = remap[empty];
+
+    size_t buckets = 1 << 16;
+    while(buckets < _nodes.size()) buckets *= 2;
+    rehash(buckets);
+    _collections++;
+}
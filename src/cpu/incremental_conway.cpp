@@ -0,0 +1,83 @@
+#include <algorithm>
+
+#include "incremental_conway.h"
+
+template <typename Fn>
+void IncrementalEngine::forNeighbours(int cell, int flag_3d, Fn fn) const{
+    const int plane_size = _N * _M;
+    int k = cell / plane_size, i = (cell % plane_size) / _M, j = cell % _M;
+
+    // wrapped coordinates, the same cell can appear more than once on small worlds
+    int is[3] = {i == 0 ? _N - 1 : i - 1, i, i == _N - 1 ? 0 : i + 1};
+    int js[3] = {j == 0 ? _M - 1 : j - 1, j, j == _M - 1 ? 0 : j + 1};
+    int ks[3] = {k == 0 ? _D - 1 : k - 1, k, k == _D - 1 ? 0 : k + 1};
+
+    for(int dk = flag_3d ? 0 : 1; dk < (flag_3d ? 3 : 2); dk++){
+        for(int di = 0; di < 3; di++){
+            for(int dj = 0; dj < 3; dj++){
+                if(dk == 1 && di == 1 && dj == 1) continue;
+                fn(ks[dk] * plane_size + is[di] * _M + js[dj]);
+            }
+        }
+    }
+}
+
+void IncrementalEngine::load(const std::vector<int> &world, int N, int M, int D){
+    _N = N, _M = M, _D = D;
+    _cells.assign(world.begin(), world.begin() + (size_t)N * M * D);
+    _counts.resize(_cells.size());
+    _stamp.assign(_cells.size(), 0);
+    _step = 0;
+    _counts_3d = -1;
+}
+
+void IncrementalEngine::recount(int flag_3d){
+    std::fill(_counts.begin(), _counts.end(), 0);
+    _changed.clear();
+    for(int cell = 0; cell < (int)_cells.size(); cell++){
+        if(!_cells[cell]) continue;
+        forNeighbours(cell, flag_3d, [&](int n){ _counts[n]++; });
+
+        // without neighbours nothing is born, so only live cells and their neighbours can change
+        _changed.push_back(cell);
+    }
+    _counts_3d = flag_3d;
+}
+
+void IncrementalEngine::step(int flag_3d){
+    if(_counts_3d != flag_3d) recount(flag_3d);
+    const uint8_t target = flag_3d ? 5 : 3;
+
+    // cells whose count or state changed on the last step
+    _step++;
+    _candidates.clear();
+    auto addCandidate = [&](int cell){
+        if(_stamp[cell] == _step) return;
+        _stamp[cell] = _step;
+        _candidates.push_back(cell);
+    };
+    for(int cell : _changed){
+        addCandidate(cell);
+        forNeighbours(cell, flag_3d, addCandidate);
+    }
+    _evaluated = _candidates.size();
+
+    // the rule is evaluated on the old state before anything is updated
+    _flipped.clear();
+    for(int cell : _candidates){
+        uint8_t alive = (_counts[cell] | _cells[cell]) == target;
+        if(alive != _cells[cell]) _flipped.push_back(cell);
+    }
+
+    // births and deaths update the counts of their neighbours
+    for(int cell : _flipped){
+        _cells[cell] ^= 1;
+        int delta = _cells[cell] ? 1 : -1;
+        forNeighbours(cell, flag_3d, [&](int n){ _counts[n] += delta; });
+    }
+    _changed.swap(_flipped);
+}
+
+void IncrementalEngine::store(std::vector<int> &world){
+    std::copy(_cells.begin(), _cells.end(), world.begin());
+}
@@ -0,0 +1,152 @@
+#include <algorithm>
+
+#include "ltl_conway.h"
+
+/** Wraps a coordinate into [0, size), windows wider than the world go around it more than once */
+static inline int wrap(int x, int size){
+    x %= size;
+    return x < 0 ? x + size : x;
+}
+
+/** Ranges of a rule by state of the cell, applied without branches */
+struct Ranges
+{
+    int min[2];         /* lowest box sum, including the cell, that gives a live cell */
+    unsigned width[2];  /* box sums above min that also give a live cell */
+
+    Ranges(const LtlRule &rule){
+        // a count that doesn't include the cell is one less than the box sum of a live cell
+        set(0, rule.birth_min, rule.birth_max);
+        set(1, rule.survive_min + !rule.count_center, rule.survive_max + !rule.count_center);
+    }
+
+    void set(int cell, int low, int high){
+        // box sums are never negative, an empty range starts below them
+        min[cell] = low <= high ? low : -1;
+        width[cell] = low <= high ? high - low : 0;
+    }
+
+    /** Applies the rule to a cell
+     * @param sum box sum of the cell, including the cell
+     * @param cell state of the cell
+     */
+    uint8_t operator()(int sum, uint8_t cell) const { return (unsigned)(sum - min[cell]) <= width[cell]; }
+};
+
+LtlEngine::LtlEngine(int workers) : _pool(std::max(workers, 1)) {}
+
+void LtlEngine::setRule(const LtlRule &rule, int flag_3d){
+    _rules[flag_3d ? 1 : 0] = rule;
+    int &radius = _rules[flag_3d ? 1 : 0].radius;
+    radius = std::min(std::max(radius, 1), (int)LtlRule::max_radius);
+}
+
+void LtlEngine::load(const std::vector<int> &world, int N, int M, int D){
+    _N = N, _M = M, _D = D;
+    _current.assign(world.begin(), world.begin() + (size_t)N * M * D);
+    _next.resize(_current.size());
+    _rows.resize(_current.size());
+    _columns.resize(_current.size());
+}
+
+void LtlEngine::sumRows(int begin, int end, int R){
+    for(int row = begin; row < end; row++){
+        const uint8_t *cells = &_current[(size_t)row * _M];
+        uint16_t *out = &_rows[(size_t)row * _M];
+
+        uint16_t sum = 0;
+        for(int d = -R; d <= R; d++) sum += cells[wrap(d, _M)];
+        out[0] = sum;
+
+        // columns entering and leaving the window
+        int enter = wrap(R + 1, _M), leave = wrap(-R, _M);
+        for(int j = 1; j < _M; j++){
+            sum += cells[enter] - cells[leave];
+            out[j] = sum;
+            enter = enter + 1 == _M ? 0 : enter + 1;
+            leave = leave + 1 == _M ? 0 : leave + 1;
+        }
+    }
+}
+
+void LtlEngine::sumColumns(int begin, int end, const LtlRule &rule, int flag_3d){
+    const int R = rule.radius;
+    const size_t plane_size = (size_t)_N * _M;
+
+    for(int k = 0; k < _D; k++){
+        const uint16_t *rows = &_rows[k * plane_size];
+        uint16_t *out = &_columns[k * plane_size];
+
+        std::fill(out + begin, out + end, 0);
+        for(int d = -R; d <= R; d++){
+            const uint16_t *row = &rows[(size_t)wrap(d, _N) * _M];
+            for(int j = begin; j < end; j++) out[j] += row[j];
+        }
+
+        // rows entering and leaving the window, every row starts from the one above
+        for(int i = 1; i < _N; i++){
+            const uint16_t *enter = &rows[(size_t)wrap(i + R, _N) * _M], *leave = &rows[(size_t)wrap(i - R - 1, _N) * _M];
+            const uint16_t *above = &out[(size_t)(i - 1) * _M];
+            uint16_t *sums = &out[(size_t)i * _M];
+            for(int j = begin; j < end; j++) sums[j] = above[j] + enter[j] - leave[j];
+        }
+
+        if(flag_3d) continue;
+        const Ranges ranges(rule);
+        for(int i = 0; i < _N; i++){
+            size_t offset = k * plane_size + (size_t)i * _M;
+            for(int j = begin; j < end; j++) _next[offset + j] = ranges(_columns[offset + j], _current[offset + j]);
+        }
+    }
+}
+
+void LtlEngine::sumPlanes(int begin, int end, const LtlRule &rule){
+    const int R = rule.radius;
+    const size_t plane_size = (size_t)_N * _M;
+
+    uint16_t *out = &_rows[0];
+    std::fill(out + begin, out + end, 0);
+    for(int d = -R; d <= R; d++){
+        const uint16_t *plane = &_columns[wrap(d, _D) * plane_size];
+        for(int c = begin; c < end; c++) out[c] += plane[c];
+    }
+
+    // planes entering and leaving the window, every plane starts from the one before
+    for(int k = 1; k < _D; k++){
+        const uint16_t *enter = &_columns[wrap(k + R, _D) * plane_size], *leave = &_columns[wrap(k - R - 1, _D) * plane_size];
+        const uint16_t *before = &_rows[(k - 1) * plane_size];
+        uint16_t *sums = &_rows[k * plane_size];
+        for(int c = begin; c < end; c++) sums[c] = before[c] + enter[c] - leave[c];
+    }
+
+    const Ranges ranges(rule);
+    for(int k = 0; k < _D; k++){
+        size_t offset = k * plane_size;
+        for(int c = begin; c < end; c++) _next[offset + c] = ranges(_rows[offset + c], _current[offset + c]);
+    }
+}
+
+void LtlEngine::step(int flag_3d){
+    const LtlRule &rule = _rules[flag_3d ? 1 : 0];
+    const int workers = _pool.size();
+
+    // every pass reads the whole output of the one before, so they are separate jobs
+    _pool.run([&](int worker){
+        sumRows((long long)_N * _D * worker / workers, (long long)_N * _D * (worker + 1) / workers, rule.radius);
+    });
+    _pool.run([&](int worker){
+        sumColumns((long long)_M * worker / workers, (long long)_M * (worker + 1) / workers, rule, flag_3d);
+    });
+    if(flag_3d){
+        const long long plane_size = (long long)_N * _M;
+        _pool.run([&](int worker){
+            sumPlanes(plane_size * worker / workers, plane_size * (worker + 1) / workers, rule);
+        });
+    }
+
+    _current.swap(_next);
+}
+
+void LtlEngine::store(std::vector<int> &world){
+    std::copy(_current.begin(), _current.end(), world.begin());
+}
@@ -0,0 +1,136 @@
+#include <algorithm>
+
+#include "lut_conway.h"
+
+/* A key holds row r of the 4x4 block on bits 4r to 4r+3, column c on bit 4r+c.
+ * An entry holds cell (1,1) on bit 0, (1,2) on bit 1, (2,1) on bit 2 and (2,2) on bit 3.
+ */
+LutEngine::LutEngine(uint16_t birth, uint16_t survive){
+    _table.resize(1 << 16);
+    for(uint32_t key = 0; key < (1 << 16); key++){
+        uint8_t entry = 0;
+        for(int r = 1; r <= 2; r++){
+            for(int c = 1; c <= 2; c++){
+                int neighbours = 0;
+                for(int dr = -1; dr <= 1; dr++){
+                    for(int dc = -1; dc <= 1; dc++){
+                        if(dr || dc) neighbours += (key >> ((r + dr) * 4 + c + dc)) & 1;
+                    }
+                }
+                bool alive = (key >> (r * 4 + c)) & 1;
+                if(((alive ? survive : birth) >> neighbours) & 1) entry |= 1 << ((r - 1) * 2 + c - 1);
+            }
+        }
+        _table[key] = entry;
+    }
+}
+
+void LutEngine::load(const std::vector<int> &world, int N, int M, int D){
+    _N = N, _M = M, _D = D;
+    _words = (M + 63) / 64;
+
+    _current.assign((size_t)_words * N * D, 0);
+    _next.assign(_current.size(), 0);
+    _spare.assign(_words, 0);
+
+    for(int k = 0; k < D; k++){
+        for(int i = 0; i < N; i++){
+            uint64_t *row = &_current[((size_t)k * N + i) * _words];
+            const int *cells = &world[((size_t)k * N + i) * M];
+            for(int j = 0; j < M; j++){
+                if(cells[j]) row[j / 64] |= uint64_t(1) << (j % 64);
+            }
+        }
+    }
+}
+
+uint32_t LutEngine::nibble(const uint64_t *row, int j) const{
+    if(j < 0 || j + 4 > _M){
+        uint32_t bits = 0;
+        for(int c = 0; c < 4; c++){
+            int column = (j + c + _M) % _M;
+            bits |= ((row[column / 64] >> (column % 64)) & 1) << c;
+        }
+        return bits;
+    }
+
+    int w = j / 64, s = j % 64;
+    uint64_t bits = row[w] >> s;
+    if(s > 60) bits |= row[w + 1] << (64 - s);
+    return bits & 15;
+}
+
+void LutEngine::stepRows(const uint64_t *const rows[4], uint64_t *out0, uint64_t *out1) const{
+    const int full = _M / 64;
+
+    // whole words, every row is shifted one column so block b reads bits 2b to 2b+3
+    for(int w = 0; w < full; w++){
+        uint64_t window[4], last[4];
+        for(int r = 0; r < 4; r++){
+            int west = (w * 64 - 1 + _M) % _M, east = (w * 64 + 64) % _M;
+            uint64_t word = rows[r][w];
+            window[r] = (word << 1) | ((rows[r][west / 64] >> (west % 64)) & 1);
+            last[r] = (window[r] >> 62) | (word >> 63) << 2 | ((rows[r][east / 64] >> (east % 64)) & 1) << 3;
+        }
+
+        uint64_t next0 = 0, next1 = 0;
+        for(int b = 0; b < 31; b++){
+            uint32_t key = (window[0] & 15) | (window[1] & 15) << 4 | (window[2] & 15) << 8 | (window[3] & 15) << 12;
+            uint64_t entry = _table[key];
+            next0 |= (entry & 3) << (2 * b);
+            next1 |= (entry >> 2) << (2 * b);
+            for(int r = 0; r < 4; r++) window[r] >>= 2;
+        }
+        uint64_t entry = _table[last[0] | last[1] << 4 | last[2] << 8 | last[3] << 12];
+        out0[w] = next0 | (entry & 3) << 62;
+        out1[w] = next1 | (entry >> 2) << 62;
+    }
+    if(full == _words) return;
+
+    // the last word is partial, blocks start on even columns and with an odd width the last one
+    // overlaps the one before. With a single column left that block starts on the word before, so
+    // its cells are written one by one
+    out0[full] = out1[full] = 0;
+    for(int j = full * 64; j < _M; j += 2){
+        if(j + 2 > _M) j = std::max(_M - 2, 0);
+
+        uint32_t key = nibble(rows[0], j - 1) | nibble(rows[1], j - 1) << 4 | nibble(rows[2], j - 1) << 8 | nibble(rows[3], j - 1) << 12;
+        uint64_t entry = _table[key];
+
+        // a world one column wide only has the first cell of the block
+        for(int c = 0; c < 2 && j + c < _M; c++){
+            int column = j + c;
+            out0[column / 64] |= ((entry >> c) & 1) << (column % 64);
+            out1[column / 64] |= ((entry >> (2 + c)) & 1) << (column % 64);
+        }
+    }
+}
+
+void LutEngine::step(int){
+    for(int k = 0; k < _D; k++){
+        const uint64_t *plane = &_current[(size_t)k * _N * _words];
+        uint64_t *out = &_next[(size_t)k * _N * _words];
+
+        // pairs of rows, with an odd height the last pair overlaps the one before, a world one row
+        // high writes its second row to a spare one
+        for(int i = 0; i < _N; i += 2){
+            if(i + 2 > _N) i = std::max(_N - 2, 0);
+
+            const uint64_t *rows[4];
+            for(int r = 0; r < 4; r++) rows[r] = &plane[(size_t)((i + r - 1 + _N) % _N) * _words];
+            uint64_t *second = _N > 1 ? &out[(size_t)(i + 1) * _words] : _spare.data();
+            stepRows(rows, &out[(size_t)i * _words], second);
+        }
+    }
+    _current.swap(_next);
+}
+
+void LutEngine::store(std::vector<int> &world){
+    for(int k = 0; k < _D; k++){
+        for(int i = 0; i < _N; i++){
+            const uint64_t *row = &_current[((size_t)k * _N + i) * _words];
+            int *cells = &world[((size_t)k * _N + i) * _M];
+            for(int j = 0; j < _M; j++) cells[j] = (row[j / 64] >> (j % 64)) & 1;
+        }
+    }
+}
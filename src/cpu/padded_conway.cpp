@@ -0,0 +1,41 @@
+#include <algorithm>
+
+#include "padded_conway.h"
+
+void PaddedEngine::load(const std::vector<int> &world, int N, int M, int D){
+    _layout = PaddedLayout(N, M, D, sizeof(uint8_t));
+    _current.assign(_layout.size(), 0);
+    _next.assign(_layout.size(), 0);
+    _sums.resize(_layout.pitch);
+    padWorld(_layout, world.data(), _current.data());
+}
+
+void PaddedEngine::step(int flag_3d){
+    const int N = _layout.N, M = _layout.M, D = _layout.D;
+    const int pitch = _layout.pitch;
+    const size_t plane_size = _layout.plane_size;
+    const uint8_t target = flag_3d ? 5 : 3;
+
+    fillHalo(_layout, _current.data(), _boundary, flag_3d);
+
+    for(int k = 0; k < D; k++){
+        for(int i = 0; i < N; i++){
+            // neighbours are at fixed offsets, the halo column -1 is the first one added
+            const uint8_t *center = &_current[_layout.index(i, -1, k)];
+            std::fill(_sums.begin(), _sums.begin() + M + 2, 0);
+            for(int p = flag_3d ? -1 : 0; p <= (flag_3d ? 1 : 0); p++){
+                const uint8_t *row = center + p * (ptrdiff_t)plane_size;
+                _kernel.addRow(_sums.data(), row - pitch, M + 2);
+                _kernel.addRow(_sums.data(), row, M + 2);
+                _kernel.addRow(_sums.data(), row + pitch, M + 2);
+            }
+            _kernel.applyRule(&_sums[1], center + 1, &_next[_layout.index(i, 0, k)], M, target);
+        }
+    }
+
+    _current.swap(_next);
+}
+
+void PaddedEngine::store(std::vector<int> &world){
+    unpadWorld(_layout, _current.data(), world.data());
+}
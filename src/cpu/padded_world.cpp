@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <cstring>
+
+#include "padded_world.h"
+
+PaddedLayout::PaddedLayout(int N, int M, int D, size_t cell_size) : N(N), M(M), D(D){
+    const int cells_per_line = std::max<int>(row_alignment / cell_size, 1);
+    pitch = (M + 2 + cells_per_line - 1) / cells_per_line * cells_per_line;
+    plane_size = (size_t)(N + 2) * pitch;
+}
+
+template <typename T>
+void padWorld(const PaddedLayout &layout, const int *dense, T *padded){
+    for(int k = 0; k < layout.D; k++){
+        for(int i = 0; i < layout.N; i++){
+            const int *row = &dense[((size_t)k * layout.N + i) * layout.M];
+            std::copy(row, row + layout.M, &padded[layout.index(i, 0, k)]);
+        }
+    }
+}
+
+template <typename T>
+void unpadWorld(const PaddedLayout &layout, const T *padded, int *dense){
+    for(int k = 0; k < layout.D; k++){
+        for(int i = 0; i < layout.N; i++){
+            const T *row = &padded[layout.index(i, 0, k)];
+            std::copy(row, row + layout.M, &dense[((size_t)k * layout.N + i) * layout.M]);
+        }
+    }
+}
+
+/** Gets the cell of the world the halo copies on an axis
+ * @param edge -1 for the halo before the first cell, size for the one after the last
+ * @param size size of the axis
+ * @return coordinate of the cell, -1 if the halo holds dead cells
+ */
+static int haloSource(int edge, int size, Boundary boundary){
+    switch(boundary){
+        case Boundary::Toroidal: return edge < 0 ? size - 1 : 0;
+        case Boundary::Mirrored: return edge < 0 ? 0 : size - 1;
+        default: return -1;
+    }
+}
+
+template <typename T>
+void fillHalo(const PaddedLayout &layout, T *padded, Boundary boundary, int flag_3d){
+    const int N = layout.N, M = layout.M, D = layout.D;
+    const int before_j = haloSource(-1, M, boundary), after_j = haloSource(M, M, boundary);
+    const int before_i = haloSource(-1, N, boundary), after_i = haloSource(N, N, boundary);
+    const int row_cells = M + 2;
+
+    for(int k = 0; k < D; k++){
+        // columns of every row
+        for(int i = 0; i < N; i++){
+            T *row = &padded[layout.index(i, 0, k)];
+            row[-1] = before_j < 0 ? 0 : row[before_j];
+            row[M] = after_j < 0 ? 0 : row[after_j];
+        }
+
+        // rows of the plane, with their halo columns
+        T *first = &padded[layout.index(-1, -1, k)], *last = &padded[layout.index(N, -1, k)];
+        if(before_i < 0) std::fill(first, first + row_cells, 0);
+        else std::copy_n(&padded[layout.index(before_i, -1, k)], row_cells, first);
+        if(after_i < 0) std::fill(last, last + row_cells, 0);
+        else std::copy_n(&padded[layout.index(after_i, -1, k)], row_cells, last);
+    }
+    if(!flag_3d) return;
+
+    // planes, with their halo rows and columns
+    const int before_k = haloSource(-1, D, boundary), after_k = haloSource(D, D, boundary);
+    T *first = &padded[0], *last = &padded[(D + 1) * layout.plane_size];
+    if(before_k < 0) std::fill(first, first + layout.plane_size, 0);
+    else std::copy_n(&padded[(before_k + 1) * layout.plane_size], layout.plane_size, first);
+    if(after_k < 0) std::fill(last, last + layout.plane_size, 0);
+    else std::copy_n(&padded[(after_k + 1) * layout.plane_size], layout.plane_size, last);
+}
+
+template void padWorld<int>(const PaddedLayout &, const int *, int *);
+template void padWorld<uint8_t>(const PaddedLayout &, const int *, uint8_t *);
+template void unpadWorld<int>(const PaddedLayout &, const int *, int *);
+template void unpadWorld<uint8_t>(const PaddedLayout &, const uint8_t *, int *);
+template void fillHalo<int>(const PaddedLayout &, int *, Boundary, int);
+template void fillHalo<uint8_t>(const PaddedLayout &, uint8_t *, Boundary, int);
@@ -0,0 +1,187 @@
+#include <cctype>
+#include <cstdlib>
+
+#include "rule_conway.h"
+
+/** Reads a list of numbers of neighbours, digits or numbers and ranges separated by commas */
+static bool parseCounts(const std::string &text, uint32_t &mask){
+    mask = 0;
+    if(text.find(',') == std::string::npos && text.find('-') == std::string::npos){
+        for(char c : text){
+            if(!std::isdigit((unsigned char)c)) return false;
+            mask |= uint32_t(1) << (c - '0');
+        }
+        return true;
+    }
+
+    size_t begin = 0;
+    while(begin <= text.size()){
+        size_t end = text.find(',', begin);
+        if(end == std::string::npos) end = text.size();
+        std::string item = text.substr(begin, end - begin);
+
+        size_t dash = item.find('-');
+        std::string first = item.substr(0, dash), last = dash == std::string::npos ? first : item.substr(dash + 1);
+        if(first.empty() || last.empty() || first.find_first_not_of("0123456789") != std::string::npos || last.find_first_not_of("0123456789") != std::string::npos) return false;
+
+        int from = std::atoi(first.c_str()), to = std::atoi(last.c_str());
+        if(from > to || to > 26) return false;
+        for(int count = from; count <= to; count++) mask |= uint32_t(1) << count;
+        begin = end + 1;
+    }
+    return true;
+}
+
+bool LifeRule::parse(const std::string &text, LifeRule &rule){
+    std::string upper;
+    for(char c : text){
+        if(!std::isspace((unsigned char)c)) upper += std::toupper((unsigned char)c);
+    }
+
+    LifeRule parsed = {0, 0, Neighbourhood::Moore};
+    size_t slash = upper.find('/');
+    if(upper.size() < 2 || upper[0] != 'B' || slash == std::string::npos || slash + 1 >= upper.size() || upper[slash + 1] != 'S') return false;
+
+    size_t suffix = upper.find('/', slash + 1);
+    std::string survive = upper.substr(slash + 2, suffix == std::string::npos ? std::string::npos : suffix - slash - 2);
+    if(suffix != std::string::npos){
+        std::string hood = upper.substr(suffix + 1);
+        if(hood == "V") parsed.neighbourhood = Neighbourhood::VonNeumann;
+        else if(hood != "M") return false;
+    }
+
+    if(!parseCounts(upper.substr(1, slash - 1), parsed.birth) || !parseCounts(survive, parsed.survive)) return false;
+    rule = parsed;
+    return true;
+}
+
+/** Writes a mask of numbers of neighbours, as digits if all of them are below 10 */
+static std::string countsToString(uint32_t mask){
+    bool digits = mask < (1 << 10);
+    std::string text;
+    for(int count = 0; count <= 26; count++){
+        if(!(mask >> count & 1)) continue;
+        if(!digits && !text.empty()) text += ',';
+        text += std::to_string(count);
+    }
+    return text;
+}
+
+std::string LifeRule::toString() const{
+    return "B" + countsToString(birth) + "/S" + countsToString(survive) + (neighbourhood == Neighbourhood::VonNeumann ? "/V" : "");
+}
+
+/** Masks fixed at compile time, both in one word: birth on the low half and survival on the high half */
+template <uint32_t Birth, uint32_t Survive>
+struct FixedMasks
+{
+    static constexpr uint64_t table() { return (uint64_t)Survive << 32 | Birth; }
+};
+
+/** Masks read at runtime, same layout as FixedMasks */
+struct RuntimeMasks
+{
+    uint64_t value;
+    uint64_t table() const { return value; }
+};
+
+/** Calculates the next state of a world, the neighbourhood is fixed at compile time and
+ *  the masks come from Masks, so with FixedMasks the whole kernel is a constant expression
+ *  but for the loads. Rows and planes are wrapped once per row, columns only at the edges.
+ */
+template <Neighbourhood Hood, int Dims, typename Masks>
+static void stepRule(const int *current, int *next, int N, int M, int D, Masks masks){
+    const size_t plane_size = (size_t)N * M;
+    const uint64_t table = masks.table();
+
+    for(int k = 0; k < D; k++){
+        for(int i = 0; i < N; i++){
+            // rows[p][r] is row i + r - 1 of plane k + p - 1
+            const int *rows[3][3];
+            for(int p = 0; p < 3; p++){
+                int plane = Dims == 3 ? (k + p - 1 + D) % D : k;
+                for(int r = 0; r < 3; r++) rows[p][r] = &current[plane * plane_size + (size_t)((i + r - 1 + N) % N) * M];
+            }
+            int *out = &next[k * plane_size + (size_t)i * M];
+
+            auto cell = [&](int j, int west, int east){
+                int neighbours = 0;
+                if(Hood == Neighbourhood::Moore){
+                    for(int p = (Dims == 3 ? 0 : 1); p <= (Dims == 3 ? 2 : 1); p++){
+                        for(int r = 0; r < 3; r++) neighbours += rows[p][r][west] + rows[p][r][j] + rows[p][r][east];
+                    }
+                    neighbours -= rows[1][1][j];
+                }
+                else{
+                    neighbours = rows[1][0][j] + rows[1][2][j] + rows[1][1][west] + rows[1][1][east];
+                    if(Dims == 3) neighbours += rows[0][1][j] + rows[2][1][j];
+                }
+                out[j] = (table >> (neighbours + (rows[1][1][j] << 5))) & 1;
+            };
+
+            cell(0, M - 1, M > 1 ? 1 : 0);
+            for(int j = 1; j < M - 1; j++) cell(j, j - 1, j + 1);
+            if(M > 1) cell(M - 1, M - 2, 0);
+        }
+    }
+}
+
+template <uint32_t Birth, uint32_t Survive, Neighbourhood Hood, int Dims>
+void calculateStepRule(const int *current, int *next, int N, int M, int D){
+    stepRule<Hood, Dims>(current, next, N, M, D, FixedMasks<Birth, Survive>());
+}
+
+typedef void (*RuleStepFn)(const int *current, int *next, int N, int M, int D);
+
+/** A rule with a kernel specialized at compile time */
+struct SpecializedRule
+{
+    LifeRule rule;
+    int dims;
+    RuleStepFn step;
+};
+
+#define SPECIALIZE(B, S, HOOD, DIMS) {{B, S, HOOD}, DIMS, calculateStepRule<B, S, HOOD, DIMS>}
+
+/* Rules instantiated at compile time, any other one runs on the generic kernel */
+static const SpecializedRule specialized_rules[] = {
+    SPECIALIZE(neighbourCounts({3}), neighbourCounts({2, 3}), Neighbourhood::Moore, 2),                       // Conway's Life
+    SPECIALIZE(neighbourCounts({3, 6}), neighbourCounts({2, 3}), Neighbourhood::Moore, 2),                    // HighLife
+    SPECIALIZE(neighbourCounts({2}), neighbourCounts({}), Neighbourhood::Moore, 2),                           // Seeds
+    SPECIALIZE(neighbourCounts({3, 6, 7, 8}), neighbourCounts({3, 4, 6, 7, 8}), Neighbourhood::Moore, 2),     // Day & Night
+    SPECIALIZE(neighbourCounts({1}), neighbourCounts({1, 2}), Neighbourhood::VonNeumann, 2),
+    SPECIALIZE(neighbourCounts({5}), neighbourCounts({4, 5}), Neighbourhood::Moore, 3),                       // 3D rule of the simulation
+    SPECIALIZE(neighbourCounts({6}), neighbourCounts({5, 6, 7}), Neighbourhood::Moore, 3),
+    SPECIALIZE(neighbourCounts({1}), neighbourCounts({1, 2, 3}), Neighbourhood::VonNeumann, 3),
+};
+
+#undef SPECIALIZE
+
+static RuleStepFn findSpecialized(const LifeRule &rule, int flag_3d){
+    for(const SpecializedRule &specialized : specialized_rules){
+        if(specialized.rule == rule && specialized.dims == (flag_3d ? 3 : 2)) return specialized.step;
+    }
+    return nullptr;
+}
+
+bool ruleSpecialized(const LifeRule &rule, int flag_3d){
+    return findSpecialized(rule, flag_3d) != nullptr;
+}
+
+void calculateStepRule(const int *current, int *next, int N, int M, int D, const LifeRule &rule, int flag_3d){
+    if(RuleStepFn step = findSpecialized(rule, flag_3d)){
+        step(current, next, N, M, D);
+        return;
+    }
+
+    RuntimeMasks masks = {(uint64_t)rule.survive << 32 | rule.birth};
+    bool moore = rule.neighbourhood == Neighbourhood::Moore;
+    if(flag_3d){
+        if(moore) stepRule<Neighbourhood::Moore, 3>(current, next, N, M, D, masks);
+        else stepRule<Neighbourhood::VonNeumann, 3>(current, next, N, M, D, masks);
+    }
+    else{
+        if(moore) stepRule<Neighbourhood::Moore, 2>(current, next, N, M, D, masks);
+        else stepRule<Neighbourhood::VonNeumann, 2>(current, next, N, M, D, masks);
+    }
+}
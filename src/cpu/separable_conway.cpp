@@ -0,0 +1,71 @@
+#include <algorithm>
+
+#include "separable_conway.h"
+
+void SeparableEngine::load(const std::vector<int> &world, int N, int M, int D){
+    _N = N, _M = M, _D = D;
+    _current.assign(world.begin(), world.begin() + (size_t)N * M * D);
+    _next.resize(_current.size());
+    _plane_sums.resize((size_t)3 * N * M);
+    _sums.resize(M + 2);
+}
+
+void SeparableEngine::verticalSums(int k, uint8_t *out) const{
+    const uint8_t *plane = &_current[(size_t)k * _N * _M];
+
+    for(int i = 0; i < _N; i++){
+        const uint8_t *up = &plane[(size_t)(i == 0 ? _N - 1 : i - 1) * _M];
+        const uint8_t *down = &plane[(size_t)(i == _N - 1 ? 0 : i + 1) * _M];
+        uint8_t *sums = &out[(size_t)i * _M];
+
+        std::copy(up, up + _M, sums);
+        _kernel.addRow(sums, &plane[(size_t)i * _M], _M);
+        _kernel.addRow(sums, down, _M);
+    }
+}
+
+void SeparableEngine::step(int flag_3d){
+    const size_t plane_size = (size_t)_N * _M;
+    const uint8_t target = flag_3d ? 5 : 3;
+    uint8_t *sums = &_sums[1];
+
+    // window of the vertical sums of planes k - 1, k and k + 1, each one is calculated once
+    uint8_t *window[3] = {&_plane_sums[0], &_plane_sums[plane_size], &_plane_sums[2 * plane_size]};
+    if(flag_3d && _D >= 3){
+        verticalSums(_D - 1, window[0]);
+        verticalSums(0, window[1]);
+    }
+
+    for(int k = 0; k < _D; k++){
+        if(!flag_3d) verticalSums(k, window[1]);
+        else if(_D >= 3) verticalSums(k == _D - 1 ? 0 : k + 1, window[2]);
+        else{
+            // with less than three planes some of them are the same one
+            verticalSums((k - 1 + _D) % _D, window[0]);
+            verticalSums(k, window[1]);
+            verticalSums((k + 1) % _D, window[2]);
+        }
+
+        for(int i = 0; i < _N; i++){
+            size_t row = (size_t)i * _M;
+
+            // planes pass, then the columns pass is done by the rule with a wrapped copy at each end
+            std::copy(&window[1][row], &window[1][row] + _M, sums);
+            if(flag_3d){
+                _kernel.addRow(sums, &window[0][row], _M);
+                _kernel.addRow(sums, &window[2][row], _M);
+            }
+            sums[-1] = sums[_M - 1];
+            sums[_M] = sums[0];
+
+            size_t offset = k * plane_size + row;
+            _kernel.applyRule(sums, &_current[offset], &_next[offset], _M, target);
+        }
+        if(flag_3d) std::rotate(window, window + 1, window + 3);
+    }
+    _current.swap(_next);
+}
+
+void SeparableEngine::store(std::vector<int> &world){
+    std::copy(_current.begin(), _current.end(), world.begin());
+}
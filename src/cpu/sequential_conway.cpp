@@ -0,0 +1,48 @@
+#include "sequential_conway.h"
+
+/** Calculates the next state of a cell
+ * @param current world holding the current state
+ * @param i x coordinate
+ * @param j y coordinate
+ * @param k z coordinate
+ */
+static inline int nextCell(const int *current, int i, int j, int k, int N, int M, int D, int flag_3d){
+    int gindex = k * N * M + i * M + j;
+    int neighbours = current[worldIdx(i - 1, j - 1, k, N, M, D)] + current[worldIdx(i - 1, j, k, N, M, D)] + current[worldIdx(i - 1, j + 1, k, N, M, D)] + // same k
+                    current[worldIdx(i, j - 1, k, N, M, D)] + current[worldIdx(i, j + 1, k, N, M, D)] +
+                    current[worldIdx(i + 1, j - 1, k, N, M, D)] + current[worldIdx(i + 1, j, k, N, M, D)] + current[worldIdx(i + 1, j + 1, k, N, M, D)];
+
+    if(flag_3d){
+        neighbours +=   current[worldIdx(i - 1, j - 1, k+1, N, M, D)] + current[worldIdx(i - 1, j, k+1, N, M, D)] + current[worldIdx(i - 1, j + 1, k+1, N, M, D)] + // next k
+                        current[worldIdx(i, j - 1, k+1, N, M, D)] + current[worldIdx(i, j + 1, k+1, N, M, D)] + current[worldIdx(i, j, k+1, N, M, D)] +
+                        current[worldIdx(i + 1, j - 1, k+1, N, M, D)] + current[worldIdx(i + 1, j, k+1, N, M, D)] + current[worldIdx(i + 1, j + 1, k+1, N, M, D)] +
+                        current[worldIdx(i - 1, j - 1, k-1, N, M, D)] + current[worldIdx(i - 1, j, k-1, N, M, D)] + current[worldIdx(i - 1, j + 1, k-1, N, M, D)] + // last k
+                        current[worldIdx(i, j - 1, k-1, N, M, D)] + current[worldIdx(i, j + 1, k-1, N, M, D)] + current[worldIdx(i, j, k-1, N, M, D)] +
+                        current[worldIdx(i + 1, j - 1, k-1, N, M, D)] + current[worldIdx(i + 1, j, k-1, N, M, D)] + current[worldIdx(i + 1, j + 1, k-1, N, M, D)];
+        return (current[gindex] && 4 <= neighbours && neighbours <= 5) || (!current[gindex] && neighbours == 5);
+    }
+    return neighbours == 3 || (neighbours == 2 && current[gindex]);
+}
+
+void calculateStepSequential(const int *current, int *next, int N, int M, int D, int flag_3d){
+    for(int gindex = 0; gindex < N * M * D; gindex++){
+        int k = gindex / (N * M);  
+        int i = (gindex % (N * M)) / M;
+        int j = (gindex % (N * M)) % M;
+        next[gindex] = nextCell(current, i, j, k, N, M, D, flag_3d);
+    }
+}
+
+void calculateStepSequentialTiles(const int *current, int *next, int N, int M, int D, int flag_3d, TileTracker &tiles){
+    tiles.configure(N, M, D, flag_3d);
+    std::vector<int> &changed = tiles.changed();
+
+    for(int tile : tiles.prepare()){
+        tiles.forCells(tile, [&](int i, int j, int k){
+            int gindex = k * N * M + i * M + j;
+            next[gindex] = nextCell(current, i, j, k, N, M, D, flag_3d);
+            if(next[gindex] != current[gindex]) changed[tile] = 1;
+        });
+    }
+    tiles.finish();
+}
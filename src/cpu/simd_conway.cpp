@@ -0,0 +1,171 @@
+#include <algorithm>
+
+// the vector kernels are x86 only, other hosts use the scalar ones
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86
+#include <immintrin.h>
+#endif
+
+#include "simd_conway.h"
+
+/*
+ * A cell with n neighbours is alive on the next step when (n | cell) equals the target:
+ * in 2D (B3/S23) the target is 3, that is n == 3 or n == 2 on a live cell, and in
+ * 3D (B5/S45) the target is 5, that is n == 5 or n == 4 on a live cell.
+ */
+
+static void addRowScalar(uint8_t *acc, const uint8_t *row, int M){
+    for(int j = 0; j < M; j++) acc[j] += row[j];
+}
+
+static void applyRuleScalar(const uint8_t *sums, const uint8_t *center, uint8_t *out, int M, uint8_t target){
+    for(int j = 0; j < M; j++){
+        uint8_t n = sums[j - 1] + sums[j] + sums[j + 1] - center[j];
+        out[j] = (n | center[j]) == target;
+    }
+}
+
+#ifdef SIMD_X86
+__attribute__((target("sse4.2")))
+static void addRowSSE(uint8_t *acc, const uint8_t *row, int M){
+    int j = 0;
+    for(; j + 16 <= M; j += 16){
+        __m128i a = _mm_loadu_si128((const __m128i*)(acc + j));
+        __m128i r = _mm_loadu_si128((const __m128i*)(row + j));
+        _mm_storeu_si128((__m128i*)(acc + j), _mm_add_epi8(a, r));
+    }
+    addRowScalar(acc + j, row + j, M - j);
+}
+
+__attribute__((target("sse4.2")))
+static void applyRuleSSE(const uint8_t *sums, const uint8_t *center, uint8_t *out, int M, uint8_t target){
+    const __m128i t = _mm_set1_epi8(target), one = _mm_set1_epi8(1);
+    int j = 0;
+    for(; j + 16 <= M; j += 16){
+        __m128i l = _mm_loadu_si128((const __m128i*)(sums + j - 1));
+        __m128i m = _mm_loadu_si128((const __m128i*)(sums + j));
+        __m128i r = _mm_loadu_si128((const __m128i*)(sums + j + 1));
+        __m128i c = _mm_loadu_si128((const __m128i*)(center + j));
+        __m128i n = _mm_sub_epi8(_mm_add_epi8(_mm_add_epi8(l, m), r), c);
+        __m128i alive = _mm_cmpeq_epi8(_mm_or_si128(n, c), t);
+        _mm_storeu_si128((__m128i*)(out + j), _mm_and_si128(alive, one));
+    }
+    applyRuleScalar(sums + j, center + j, out + j, M - j, target);
+}
+
+__attribute__((target("avx2")))
+static void addRowAVX2(uint8_t *acc, const uint8_t *row, int M){
+    int j = 0;
+    for(; j + 32 <= M; j += 32){
+        __m256i a = _mm256_loadu_si256((const __m256i*)(acc + j));
+        __m256i r = _mm256_loadu_si256((const __m256i*)(row + j));
+        _mm256_storeu_si256((__m256i*)(acc + j), _mm256_add_epi8(a, r));
+    }
+    addRowScalar(acc + j, row + j, M - j);
+}
+
+__attribute__((target("avx2")))
+static void applyRuleAVX2(const uint8_t *sums, const uint8_t *center, uint8_t *out, int M, uint8_t target){
+    const __m256i t = _mm256_set1_epi8(target), one = _mm256_set1_epi8(1);
+    int j = 0;
+    for(; j + 32 <= M; j += 32){
+        __m256i l = _mm256_loadu_si256((const __m256i*)(sums + j - 1));
+        __m256i m = _mm256_loadu_si256((const __m256i*)(sums + j));
+        __m256i r = _mm256_loadu_si256((const __m256i*)(sums + j + 1));
+        __m256i c = _mm256_loadu_si256((const __m256i*)(center + j));
+        __m256i n = _mm256_sub_epi8(_mm256_add_epi8(_mm256_add_epi8(l, m), r), c);
+        __m256i alive = _mm256_cmpeq_epi8(_mm256_or_si256(n, c), t);
+        _mm256_storeu_si256((__m256i*)(out + j), _mm256_and_si256(alive, one));
+    }
+    applyRuleScalar(sums + j, center + j, out + j, M - j, target);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void addRowAVX512(uint8_t *acc, const uint8_t *row, int M){
+    int j = 0;
+    for(; j + 64 <= M; j += 64){
+        __m512i a = _mm512_loadu_si512((const void*)(acc + j));
+        __m512i r = _mm512_loadu_si512((const void*)(row + j));
+        _mm512_storeu_si512((void*)(acc + j), _mm512_add_epi8(a, r));
+    }
+    addRowScalar(acc + j, row + j, M - j);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void applyRuleAVX512(const uint8_t *sums, const uint8_t *center, uint8_t *out, int M, uint8_t target){
+    const __m512i t = _mm512_set1_epi8(target), one = _mm512_set1_epi8(1);
+    int j = 0;
+    for(; j + 64 <= M; j += 64){
+        __m512i l = _mm512_loadu_si512((const void*)(sums + j - 1));
+        __m512i m = _mm512_loadu_si512((const void*)(sums + j));
+        __m512i r = _mm512_loadu_si512((const void*)(sums + j + 1));
+        __m512i c = _mm512_loadu_si512((const void*)(center + j));
+        __m512i n = _mm512_sub_epi8(_mm512_add_epi8(_mm512_add_epi8(l, m), r), c);
+        __mmask64 alive = _mm512_cmpeq_epi8_mask(_mm512_or_si512(n, c), t);
+        _mm512_storeu_si512((void*)(out + j), _mm512_maskz_mov_epi8(alive, one));
+    }
+    applyRuleScalar(sums + j, center + j, out + j, M - j, target);
+}
+#endif
+
+SimdEngine::SimdEngine(){
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512bw")){
+        _name = "SIMD (AVX-512)", _add_row = addRowAVX512, _apply_rule = applyRuleAVX512;
+    }
+    else if(__builtin_cpu_supports("avx2")){
+        _name = "SIMD (AVX2)", _add_row = addRowAVX2, _apply_rule = applyRuleAVX2;
+    }
+    else if(__builtin_cpu_supports("sse4.2")){
+        _name = "SIMD (SSE4.2)", _add_row = addRowSSE, _apply_rule = applyRuleSSE;
+    }
+    else{
+        _name = "SIMD (scalar)", _add_row = addRowScalar, _apply_rule = applyRuleScalar;
+    }
+#else
+    _name = "SIMD (scalar)", _add_row = addRowScalar, _apply_rule = applyRuleScalar;
+#endif
+}
+
+void SimdEngine::load(const std::vector<int> &world, int N, int M, int D){
+    _N = N, _M = M, _D = D;
+    _current.assign(world.begin(), world.begin() + (size_t)N * M * D);
+    _next.resize(_current.size());
+    _sums.resize(M + 2);
+}
+
+void SimdEngine::step(int flag_3d){
+    stepRows(_current.data(), _next.data(), _sums.data(), _N, _M, _D, 0, _N * _D, flag_3d);
+    _current.swap(_next);
+}
+
+void SimdEngine::stepRows(const uint8_t *current, uint8_t *next, uint8_t *sums, int N, int M, int D, int begin, int end, int flag_3d) const{
+    const size_t plane_size = (size_t)N * M;
+    const uint8_t target = flag_3d ? 5 : 3;
+    const int planes_used = flag_3d ? 3 : 1;
+    sums += 1;
+
+    for(int row = begin; row < end; row++){
+        int k = row / N, i = row % N;
+
+        // planes and rows only wrap at the edges of the world
+        int planes[3] = {k, k == 0 ? D - 1 : k - 1, k == D - 1 ? 0 : k + 1};
+        int rows[3] = {i == 0 ? N - 1 : i - 1, i, i == N - 1 ? 0 : i + 1};
+
+        // vertical sums of every column
+        std::fill(sums, sums + M, 0);
+        for(int p = 0; p < planes_used; p++){
+            for(int r : rows) _add_row(sums, &current[planes[p] * plane_size + (size_t)r * M], M);
+        }
+        sums[-1] = sums[M - 1];
+        sums[M] = sums[0];
+
+        size_t offset = k * plane_size + (size_t)i * M;
+        _apply_rule(sums, &current[offset], &next[offset], M, target);
+    }
+}
+
+void SimdEngine::store(std::vector<int> &world){
+    std::copy(_current.begin(), _current.end(), world.begin());
+}
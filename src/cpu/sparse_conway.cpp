@@ -0,0 +1,237 @@
+#include <algorithm>
+
+#include "sparse_conway.h"
+
+/** Rounds a division towards negative infinity */
+static inline long long floorDiv(long long a, long long b){
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+SparseEngine::Key SparseEngine::keyOf(long long i, long long j, long long k) const{
+    return {(int)floorDiv(i, _ci), (int)floorDiv(j, _cj), (int)floorDiv(k, _ck)};
+}
+
+int SparseEngine::chunk(const Key &key){
+    auto found = _chunks.find(key);
+    if(found != _chunks.end()) return found->second;
+
+    int slot;
+    if(!_free.empty()){
+        slot = _free.back();
+        _free.pop_back();
+    }
+    else{
+        slot = _keys.size();
+        _keys.emplace_back();
+        _alive.push_back(0);
+        _pool.resize(_pool.size() + 2 * (size_t)chunkCells());
+    }
+    std::fill(cells(slot, 0), cells(slot, 0) + 2 * chunkCells(), 0);
+    _keys[slot] = key;
+    _alive[slot] = 0;
+    _chunks.emplace(key, slot);
+    return slot;
+}
+
+void SparseEngine::setAlive(long long i, long long j, long long k){
+    Key key = keyOf(i, j, k);
+    int slot = chunk(key);
+    long long li = i - (long long)key.i * _ci, lj = j - (long long)key.j * _cj, lk = k - (long long)key.k * _ck;
+    cells(slot, _parity)[(lk * _ci + li) * _cj + lj] = 1;
+    _alive[slot] = 1;
+
+    if(_box.empty) _box = {i, j, k, i, j, k, false};
+    _box.min_i = std::min(_box.min_i, i), _box.max_i = std::max(_box.max_i, i);
+    _box.min_j = std::min(_box.min_j, j), _box.max_j = std::max(_box.max_j, j);
+    _box.min_k = std::min(_box.min_k, k), _box.max_k = std::max(_box.max_k, k);
+}
+
+void SparseEngine::load(const std::vector<int> &world, int N, int M, int D){
+    if(N != _N || M != _M || D != _D) _view_i = _view_j = _view_k = 0;
+    _N = N, _M = M, _D = D;
+
+    _chunks.clear(), _pool.clear(), _keys.clear(), _alive.clear(), _free.clear();
+    _parity = 0;
+    _box.empty = true;
+
+    for(int k = 0; k < D; k++){
+        for(int i = 0; i < N; i++){
+            for(int j = 0; j < M; j++){
+                if(world[((size_t)k * N + i) * M + j]) setAlive(_view_i + i, _view_j + j, _view_k + k);
+            }
+        }
+    }
+}
+
+void SparseEngine::edit(const std::vector<int> &world, int N, int M, int D){
+    if(N != _N || M != _M || D != _D){
+        load(world, N, M, D);
+        return;
+    }
+
+    for(int k = 0; k < D; k++){
+        for(int i = 0; i < N; i++){
+            for(int j = 0; j < M; j++){
+                long long ci = _view_i + i, cj = _view_j + j, ck = _view_k + k;
+                bool alive = world[((size_t)k * N + i) * M + j];
+                Key key = keyOf(ci, cj, ck);
+                auto found = _chunks.find(key);
+
+                // dead cells of missing chunks are already dead, empty chunks are released by the next step
+                if(found == _chunks.end()){
+                    if(alive) setAlive(ci, cj, ck);
+                    continue;
+                }
+                long long li = ci - (long long)key.i * _ci, lj = cj - (long long)key.j * _cj, lk = ck - (long long)key.k * _ck;
+                uint8_t &cell = cells(found->second, _parity)[(lk * _ci + li) * _cj + lj];
+                if(alive && !cell) setAlive(ci, cj, ck);
+                else if(!alive) cell = 0;
+            }
+        }
+    }
+}
+
+void SparseEngine::reshape(int flag_3d){
+    struct Cell { long long i, j, k; };
+    std::vector<Cell> live;
+    for(auto &[key, slot] : _chunks){
+        const uint8_t *current = cells(slot, _parity);
+        for(int c = 0; c < chunkCells(); c++){
+            if(!current[c]) continue;
+            int lk = c / (_ci * _cj), li = (c / _cj) % _ci, lj = c % _cj;
+            live.push_back({(long long)key.i * _ci + li, (long long)key.j * _cj + lj, (long long)key.k * _ck + lk});
+        }
+    }
+
+    _flag_3d = flag_3d;
+    _ci = _cj = flag_3d ? 16 : 32;
+    _ck = flag_3d ? 16 : 1;
+
+    _chunks.clear(), _pool.clear(), _keys.clear(), _alive.clear(), _free.clear();
+    _parity = 0;
+    _box.empty = true;
+    for(const Cell &cell : live) setAlive(cell.i, cell.j, cell.k);
+}
+
+void SparseEngine::gather(int slot){
+    const int pk = _flag_3d ? 1 : 0;
+    const int pi = _ci + 2, pj = _cj + 2;
+    _padded.assign((size_t)(_ck + 2 * pk) * pi * pj, 0);
+    const Key key = _keys[slot];
+
+    // every neighbour chunk fills the part of the padding it touches, missing chunks are dead
+    for(int dk = -pk; dk <= pk; dk++){
+        for(int di = -1; di <= 1; di++){
+            for(int dj = -1; dj <= 1; dj++){
+                auto found = _chunks.find({key.i + di, key.j + dj, key.k + dk});
+                if(found == _chunks.end()) continue;
+                const uint8_t *source = cells(found->second, _parity);
+
+                int k0 = dk < 0 ? _ck - 1 : 0, k1 = dk > 0 ? 1 : _ck;
+                int i0 = di < 0 ? _ci - 1 : 0, i1 = di > 0 ? 1 : _ci;
+                int j0 = dj < 0 ? _cj - 1 : 0, j1 = dj > 0 ? 1 : _cj;
+                for(int k = k0; k < k1; k++){
+                    for(int i = i0; i < i1; i++){
+                        int tk = k + pk + dk * _ck, ti = i + 1 + di * _ci, tj0 = j0 + 1 + dj * _cj;
+                        const uint8_t *from = &source[((size_t)k * _ci + i) * _cj + j0];
+                        std::copy(from, from + (j1 - j0), &_padded[((size_t)tk * pi + ti) * pj + tj0]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool SparseEngine::stepChunk(int slot, int flag_3d){
+    gather(slot);
+    const int pk = flag_3d ? 1 : 0;
+    const int pi = _ci + 2, pj = _cj + 2;
+    const uint8_t target = flag_3d ? 5 : 3;
+    const Key key = _keys[slot];
+    uint8_t *out = cells(slot, 1 - _parity);
+    bool alive = false;
+
+    for(int k = 0; k < _ck; k++){
+        for(int i = 0; i < _ci; i++){
+            for(int j = 0; j < _cj; j++){
+                uint8_t n = 0;
+                for(int dk = -pk; dk <= pk; dk++){
+                    for(int di = -1; di <= 1; di++){
+                        const uint8_t *row = &_padded[((size_t)(k + pk + dk) * pi + i + 1 + di) * pj + j + 1];
+                        n += row[-1] + row[0] + row[1];
+                    }
+                }
+                uint8_t center = _padded[((size_t)(k + pk) * pi + i + 1) * pj + j + 1];
+                n -= center;
+
+                uint8_t next = (n | center) == target;
+                out[((size_t)k * _ci + i) * _cj + j] = next;
+                if(!next) continue;
+
+                alive = true;
+                long long ci = (long long)key.i * _ci + i, cj = (long long)key.j * _cj + j, ck = (long long)key.k * _ck + k;
+                if(_box.empty) _box = {ci, cj, ck, ci, cj, ck, false};
+                _box.min_i = std::min(_box.min_i, ci), _box.max_i = std::max(_box.max_i, ci);
+                _box.min_j = std::min(_box.min_j, cj), _box.max_j = std::max(_box.max_j, cj);
+                _box.min_k = std::min(_box.min_k, ck), _box.max_k = std::max(_box.max_k, ck);
+            }
+        }
+    }
+    return alive;
+}
+
+void SparseEngine::step(int flag_3d){
+    if(flag_3d != _flag_3d) reshape(flag_3d);
+
+    // cells can be born next to live chunks, so their neighbours are allocated first
+    _grow.clear();
+    for(auto &[key, slot] : _chunks){
+        if(_alive[slot]) _grow.push_back(key);
+    }
+    for(const Key &key : _grow){
+        for(int dk = flag_3d ? -1 : 0; dk <= (flag_3d ? 1 : 0); dk++){
+            for(int di = -1; di <= 1; di++){
+                for(int dj = -1; dj <= 1; dj++) chunk({key.i + di, key.j + dj, key.k + dk});
+            }
+        }
+    }
+
+    _box.empty = true;
+    for(auto &[key, slot] : _chunks) _alive[slot] = stepChunk(slot, flag_3d);
+    _parity = 1 - _parity;
+
+    // empty chunks are released
+    for(auto it = _chunks.begin(); it != _chunks.end();){
+        if(_alive[it->second]){
+            ++it;
+            continue;
+        }
+        _free.push_back(it->second);
+        it = _chunks.erase(it);
+    }
+
+    if(_follow) centerView();
+}
+
+void SparseEngine::centerView(){
+    if(_box.empty) return;
+    _view_i = (_box.min_i + _box.max_i) / 2 - _N / 2;
+    _view_j = (_box.min_j + _box.max_j) / 2 - _M / 2;
+    if(_flag_3d) _view_k = (_box.min_k + _box.max_k) / 2 - _D / 2;
+}
+
+void SparseEngine::store(std::vector<int> &world){
+    std::fill(world.begin(), world.begin() + (size_t)_N * _M * _D, 0);
+    for(auto &[key, slot] : _chunks){
+        long long i0 = (long long)key.i * _ci, j0 = (long long)key.j * _cj, k0 = (long long)key.k * _ck;
+        if(i0 + _ci <= _view_i || i0 >= _view_i + _N || j0 + _cj <= _view_j || j0 >= _view_j + _M || k0 + _ck <= _view_k || k0 >= _view_k + _D) continue;
+
+        const uint8_t *current = cells(slot, _parity);
+        for(int c = 0; c < chunkCells(); c++){
+            if(!current[c]) continue;
+            long long k = k0 + c / (_ci * _cj) - _view_k, i = i0 + (c / _cj) % _ci - _view_i, j = j0 + c % _cj - _view_j;
+            if(i < 0 || i >= _N || j < 0 || j >= _M || k < 0 || k >= _D) continue;
+            world[((size_t)k * _N + i) * _M + j] = 1;
+        }
+    }
+}
@@ -0,0 +1,253 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "streaming_conway.h"
+
+static const char file_magic[8] = {'C', 'O', 'N', 'W', 'A', 'Y', '3', 'D'};
+
+/* planes read ahead of the window */
+static const int readahead_planes = 2;
+
+/** Gives the kernel a hint on a range of a mapping, the range is widened to whole pages */
+static void advise(uint8_t *begin, size_t bytes, int advice){
+    static const uintptr_t page = sysconf(_SC_PAGESIZE);
+    uintptr_t first = (uintptr_t)begin / page * page;
+    madvise((void*)first, (uintptr_t)begin + bytes - first, advice);
+}
+
+StreamingEngine::StreamingEngine(const std::string &path){
+    _load_path = path.empty() ? (std::filesystem::temp_directory_path() / ("conway_world_" + std::to_string(getpid()))).string() : path;
+}
+
+StreamingEngine::~StreamingEngine(){
+    closeFiles();
+}
+
+bool StreamingEngine::mapFile(int index, size_t size){
+    File &file = _files[index];
+    file.fd = ::open(_paths[index].c_str(), O_RDWR | O_CREAT, 0644);
+    if(file.fd < 0) return false;
+
+    struct stat info;
+    if(fstat(file.fd, &info) != 0 || ((size_t)info.st_size != size && ftruncate(file.fd, size) != 0)) return false;
+
+    void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file.fd, 0);
+    if(data == MAP_FAILED) return false;
+    file.data = (uint8_t*)data;
+    file.size = size;
+    return true;
+}
+
+void StreamingEngine::closeFiles(){
+    for(int index = 0; index < 2; index++){
+        File &file = _files[index];
+        if(file.data) munmap(file.data, file.size);
+        if(file.fd >= 0){
+            ::close(file.fd);
+            if(_temporary) unlink(_paths[index].c_str());
+        }
+        file = File();
+    }
+}
+
+void StreamingEngine::setSize(int N, int M, int D){
+    _N = N, _M = M, _D = D;
+    _row_words = (M + 63) / 64;
+    _plane_bytes = (size_t)N * _row_words * sizeof(uint64_t);
+    _window.resize((size_t)3 * N * M);
+    _out.resize((size_t)N * M);
+    _sums.resize(M + 2);
+}
+
+void StreamingEngine::writeHeader(int file){
+    FileHeader header = {};
+    std::memcpy(header.magic, file_magic, sizeof(file_magic));
+    header.rows = _N, header.cols = _M, header.planes = _D;
+    header.generation = _generation;
+    std::memcpy(_files[file].data, &header, sizeof(header));
+}
+
+void StreamingEngine::unpackPlane(int file, int k, uint8_t *cells) const{
+    const uint64_t *words = (const uint64_t*)plane(file, k);
+    for(int i = 0; i < _N; i++, cells += _M){
+        for(size_t w = 0; w < _row_words; w++){
+            uint64_t word = words[i * _row_words + w];
+            int count = std::min<int>(64, _M - w * 64);
+            for(int b = 0; b < count; b++) cells[w * 64 + b] = (word >> b) & 1;
+        }
+    }
+}
+
+void StreamingEngine::packPlane(const uint8_t *cells, int file, int k){
+    uint64_t *words = (uint64_t*)plane(file, k);
+    for(int i = 0; i < _N; i++, cells += _M){
+        for(size_t w = 0; w < _row_words; w++){
+            uint64_t word = 0;
+            int count = std::min<int>(64, _M - w * 64);
+            for(int b = 0; b < count; b++) word |= (uint64_t)cells[w * 64 + b] << b;
+            words[i * _row_words + w] = word;
+        }
+    }
+}
+
+void StreamingEngine::load(const std::vector<int> &world, int N, int M, int D){
+    // a world loaded from the dense one always goes to the engine's own files
+    if(!_temporary || _N != N || _M != M || _D != D || !_files[0].data){
+        closeFiles();
+        _temporary = true;
+        _paths[0] = _load_path;
+        _paths[1] = _load_path + ".next";
+        setSize(N, M, D);
+        size_t size = data_offset + (size_t)D * _plane_bytes;
+        if(!mapFile(0, size) || !mapFile(1, size)){
+            std::perror("Out of core engine");
+            closeFiles();
+            return;
+        }
+    }
+    _current = 0;
+    _generation = 0;
+
+    for(int k = 0; k < D; k++){
+        for(size_t c = 0; c < (size_t)N * M; c++) _out[c] = world[(size_t)k * N * M + c] != 0;
+        packPlane(_out.data(), 0, k);
+    }
+    writeHeader(0);
+}
+
+/** Reads the header of a world file
+ * @return false if the file is not a world file
+ */
+static bool readHeader(const std::string &path, StreamingEngine::FileHeader &header){
+    FILE *file = std::fopen(path.c_str(), "rb");
+    bool valid = file && std::fread(&header, sizeof(header), 1, file) == 1 && std::memcmp(header.magic, file_magic, sizeof(file_magic)) == 0;
+    if(file) std::fclose(file);
+    return valid;
+}
+
+bool StreamingEngine::open(const std::string &path){
+    closeFiles();
+    _temporary = false;
+    _paths[0] = path;
+    _paths[1] = path + ".next";
+
+    FileHeader header, next;
+    if(!readHeader(path, header)) return false;
+
+    // the last generation is in whichever file was written last
+    _current = 0;
+    if(readHeader(_paths[1], next) && next.rows == header.rows && next.cols == header.cols && next.planes == header.planes && next.generation > header.generation){
+        header = next;
+        _current = 1;
+    }
+
+    setSize(header.rows, header.cols, header.planes);
+    _generation = header.generation;
+    size_t size = data_offset + (size_t)_D * _plane_bytes;
+    if(!mapFile(0, size) || !mapFile(1, size)){
+        closeFiles();
+        return false;
+    }
+    return true;
+}
+
+bool StreamingEngine::createWorldFile(const std::string &path, int N, int M, int D, double density, uint32_t seed){
+    FILE *file = std::fopen(path.c_str(), "wb");
+    if(!file) return false;
+
+    FileHeader header = {};
+    std::memcpy(header.magic, file_magic, sizeof(file_magic));
+    header.rows = N, header.cols = M, header.planes = D;
+    std::vector<uint8_t> page(data_offset, 0);
+    std::memcpy(page.data(), &header, sizeof(header));
+    bool written = std::fwrite(page.data(), 1, page.size(), file) == page.size();
+
+    std::mt19937 gen(seed);
+    const uint32_t threshold = (uint32_t)std::min(density * 4294967296.0, 4294967295.0);
+    const size_t row_words = (M + 63) / 64;
+    std::vector<uint64_t> words((size_t)N * row_words);
+    for(int k = 0; k < D && written; k++){
+        for(int i = 0; i < N; i++){
+            for(int j = 0; j < M; j++){
+                if(gen() < threshold) words[i * row_words + j / 64] |= (uint64_t)1 << (j % 64);
+            }
+        }
+        written = std::fwrite(words.data(), sizeof(uint64_t), words.size(), file) == words.size();
+        std::fill(words.begin(), words.end(), 0);
+    }
+    return std::fclose(file) == 0 && written;
+}
+
+void StreamingEngine::step(int flag_3d){
+    if(!_files[0].data) return;
+    auto start = std::chrono::steady_clock::now();
+    const size_t plane_size = (size_t)_N * _M;
+    const uint8_t target = flag_3d ? 5 : 3;
+    const int next_file = 1 - _current;
+
+    // the window holds the planes before, at and after the one being calculated
+    uint8_t *before = &_window[0], *center = &_window[plane_size], *after = &_window[2 * plane_size];
+    advise(plane(_current, 0), _D * _plane_bytes, MADV_SEQUENTIAL);
+    advise(plane(next_file, 0), _D * _plane_bytes, MADV_SEQUENTIAL);
+    unpackPlane(_current, 0, center);
+    if(flag_3d){
+        unpackPlane(_current, _D - 1, before);
+        unpackPlane(_current, 1 % _D, after);
+    }
+
+    uint8_t *sums = &_sums[1];
+    for(int k = 0; k < _D; k++){
+        if(k + 1 + readahead_planes < _D) advise(plane(_current, k + 1 + readahead_planes), _plane_bytes, MADV_WILLNEED);
+
+        const uint8_t *planes[3] = {center, before, after};
+        for(int i = 0; i < _N; i++){
+            int rows[3] = {i == 0 ? _N - 1 : i - 1, i, i == _N - 1 ? 0 : i + 1};
+            std::fill(sums, sums + _M, 0);
+            for(int p = 0; p < (flag_3d ? 3 : 1); p++){
+                for(int r : rows) _kernel.addRow(sums, planes[p] + (size_t)r * _M, _M);
+            }
+            sums[-1] = sums[_M - 1];
+            sums[_M] = sums[0];
+            _kernel.applyRule(sums, center + (size_t)i * _M, &_out[(size_t)i * _M], _M, target);
+        }
+
+        // the written plane can go to disk while the next ones are calculated, and the plane
+        // that left the window is no longer needed, so neither takes memory from the window
+        packPlane(_out.data(), next_file, k);
+        advise(plane(next_file, k), _plane_bytes, MADV_DONTNEED);
+        if(k > 0) advise(plane(_current, k - 1), _plane_bytes, MADV_DONTNEED);
+
+        if(k + 1 == _D) break;
+        if(flag_3d){
+            std::swap(before, center);
+            std::swap(center, after);
+            unpackPlane(_current, (k + 2) % _D, after);
+        }
+        else unpackPlane(_current, k + 1, center);
+    }
+
+    _current = next_file;
+    _generation++;
+    writeHeader(_current);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    _planes_per_second = elapsed.count() > 0 ? _D / elapsed.count() : 0;
+}
+
+void StreamingEngine::store(std::vector<int> &world){
+    if(!_files[0].data) return;
+    const size_t plane_size = (size_t)_N * _M;
+    for(int k = 0; k < _D; k++){
+        unpackPlane(_current, k, _out.data());
+        std::copy(_out.begin(), _out.end(), world.begin() + k * plane_size);
+    }
+}
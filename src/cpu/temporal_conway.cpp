@@ -0,0 +1,84 @@
+#include <algorithm>
+
+#include "temporal_conway.h"
+
+/** Wraps a coordinate into [0, size), the border of a tile can go around a small world more than once */
+static inline int wrap(int x, int size){
+    x %= size;
+    return x < 0 ? x + size : x;
+}
+
+TemporalEngine::TemporalEngine(int generations){
+    setGenerations(generations);
+}
+
+void TemporalEngine::setGenerations(int generations){
+    _generations = std::min(std::max(generations, 1), max_generations);
+}
+
+void TemporalEngine::load(const std::vector<int> &world, int N, int M, int D){
+    _N = N, _M = M, _D = D;
+    _current.assign(world.begin(), world.begin() + (size_t)N * M * D);
+    _next.resize(_current.size());
+
+    size_t side = tile_size_3d + 2 * max_generations;
+    for(auto &tile : _tile) tile.resize(std::max((size_t)(tile_rows_2d + 2 * max_generations), side * side) * tile_width);
+    _columns.resize(tile_width);
+    _sums.resize(tile_width + 2);
+}
+
+void TemporalEngine::stepTile(int i0, int j0, int k0, int ti, int tj, int tk, int flag_3d){
+    const int h = _generations, hk = flag_3d ? _generations : 0;
+    const int Wi = ti + 2 * h, Wj = tj + 2 * h, Wk = tk + 2 * hk;
+
+    // reads the tile with its border, wrapping around the world
+    for(int c = 0; c < Wj; c++) _columns[c] = wrap(j0 - h + c, _M);
+    for(int lk = 0; lk < Wk; lk++){
+        int k = wrap(k0 - hk + lk, _D);
+        for(int li = 0; li < Wi; li++){
+            const uint8_t *row = &_current[((size_t)k * _N + wrap(i0 - h + li, _N)) * _M];
+            uint8_t *out = &_tile[0][((size_t)lk * Wi + li) * Wj];
+            // columns are contiguous until they wrap around
+            for(int c = 0; c < Wj;){
+                int run = std::min(Wj - c, _M - _columns[c]);
+                std::copy(row + _columns[c], row + _columns[c] + run, out + c);
+                c += run;
+            }
+        }
+    }
+
+    // every generation the valid part of the tile loses one cell on each side, the tile is
+    // calculated as a small world that wraps around, wrapping only spoils the part already lost
+    for(int g = 1; g <= _generations; g++){
+        const int gk = flag_3d ? g : 0;
+        _kernel.stepRows(_tile[(g - 1) % 2].data(), _tile[g % 2].data(), _sums.data(), Wi, Wj, Wk, gk * Wi, (Wk - gk) * Wi, flag_3d);
+    }
+
+    // writes the inner tile
+    const uint8_t *result = _tile[_generations % 2].data();
+    for(int lk = 0; lk < tk; lk++){
+        for(int li = 0; li < ti; li++){
+            const uint8_t *row = &result[((size_t)(lk + hk) * Wi + li + h) * Wj + h];
+            std::copy(row, row + tj, &_next[((size_t)(k0 + lk) * _N + i0 + li) * _M + j0]);
+        }
+    }
+}
+
+void TemporalEngine::step(int flag_3d){
+    const int TI = flag_3d ? tile_size_3d : tile_rows_2d;
+    const int TJ = tile_width - 2 * _generations;
+    const int TK = flag_3d ? tile_size_3d : 1;
+
+    for(int k0 = 0; k0 < _D; k0 += TK){
+        for(int i0 = 0; i0 < _N; i0 += TI){
+            for(int j0 = 0; j0 < _M; j0 += TJ){
+                stepTile(i0, j0, k0, std::min(TI, _N - i0), std::min(TJ, _M - j0), std::min(TK, _D - k0), flag_3d);
+            }
+        }
+    }
+    _current.swap(_next);
+}
+
+void TemporalEngine::store(std::vector<int> &world){
+    std::copy(_current.begin(), _current.end(), world.begin());
+}
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <atomic>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "thread_pool.h"
+#include "world_allocator.h"
+
+ThreadPool::ThreadPool(int workers) : _nodes(std::max(workers, 1), 0){
+    for(int i = 1; i < workers; i++){
+        _threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _start.notify_all();
+    for(auto &thread : _threads) thread.join();
+}
+
+void ThreadPool::workerLoop(int worker){
+    int seen = 0;
+    std::unique_lock<std::mutex> lock(_mutex);
+    while(true){
+        _start.wait(lock, [&]{ return _stop || _generation != seen; });
+        if(_stop) return;
+        seen = _generation;
+
+        lock.unlock();
+        _fn(_job, worker);
+        lock.lock();
+
+        if(--_pending == 0) _done.notify_one();
+    }
+}
+
+void ThreadPool::dispatch(void (*fn)(void*, int), void *job){
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _fn = fn, _job = job;
+        _pending = _threads.size();
+        _generation++;
+    }
+    _start.notify_all();
+
+    fn(job, 0);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [&]{ return _pending == 0; });
+}
+
+int ThreadPool::pin(){
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t allowed;
+    if(sched_getaffinity(0, sizeof(allowed), &allowed) == 0){
+        for(int cpu = 0; cpu < CPU_SETSIZE; cpu++){
+            if(CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+        }
+    }
+#endif
+    if(cpus.empty()) return 0;
+    std::stable_sort(cpus.begin(), cpus.end(), [](int a, int b){ return cpuNode(a) < cpuNode(b); });
+
+    // worker 0 is whichever thread calls run(), like the one drawing the window, it keeps its
+    // affinity so the threads it creates later aren't bound to a single cpu
+    std::atomic<int> pinned{0};
+    run([&](int worker){
+        if(worker == 0){
+#ifdef __linux__
+            int cpu = sched_getcpu();
+            if(cpu >= 0) _nodes[0] = cpuNode(cpu);
+#endif
+            return;
+        }
+        int cpu = cpus[worker % cpus.size()];
+        if(pinThread(cpu)){
+            _nodes[worker] = cpuNode(cpu);
+            pinned++;
+        }
+    });
+    return pinned;
+}
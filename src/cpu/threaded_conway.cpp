@@ -0,0 +1,45 @@
+#include <algorithm>
+
+#include "threaded_conway.h"
+
+ThreadedEngine::ThreadedEngine(int workers, bool pin) : _pool(std::max(workers, 1)){
+    if(pin) _pool.pin();
+}
+
+void ThreadedEngine::load(const std::vector<int> &world, int N, int M, int D){
+    _N = N, _M = M, _D = D;
+    const size_t size = (size_t)N * M * D;
+
+    // a new world is left untouched, its pages are placed by the first worker writing them
+    bool placed = _current.size() == size;
+    if(!placed){
+        _current = WorldVector<uint8_t>(size);
+        _next = WorldVector<uint8_t>(size);
+    }
+    _sums.resize((size_t)(M + 2) * _pool.size());
+
+    _pool.run([&](int worker){
+        size_t begin = (size_t)bandBegin(worker) * M, end = (size_t)bandBegin(worker + 1) * M;
+        std::copy(world.begin() + begin, world.begin() + end, _current.begin() + begin);
+        std::fill(_next.begin() + begin, _next.begin() + end, 0);
+        if(!placed && end > begin){
+            recordPlacement(_current.data() + begin, _pool.node(worker), end - begin);
+            recordPlacement(_next.data() + begin, _pool.node(worker), end - begin);
+        }
+    });
+}
+
+void ThreadedEngine::step(int flag_3d){
+    _pool.run([&](int worker){
+        // contiguous bands of rows, in 3D a band holds whole planes when D is a multiple of workers
+        int begin = bandBegin(worker), end = bandBegin(worker + 1);
+        uint8_t *sums = &_sums[(size_t)(_M + 2) * worker];
+        _kernel.stepRows(_current.data(), _next.data(), sums, _N, _M, _D, begin, end, flag_3d);
+    });
+
+    _current.swap(_next);
+}
+
+void ThreadedEngine::store(std::vector<int> &world){
+    std::copy(_current.begin(), _current.end(), world.begin());
+}
@@ -0,0 +1,62 @@
+#include <algorithm>
+
+#include "tile_tracker.h"
+
+#define tile_size_2d 32
+#define tile_size_3d 8
+
+void TileTracker::configure(int N, int M, int D, int flag_3d){
+    if(N == _N && M == _M && D == _D && flag_3d == _flag_3d) return;
+
+    _N = N, _M = M, _D = D, _flag_3d = flag_3d;
+    _tile_i = _tile_j = flag_3d ? tile_size_3d : tile_size_2d;
+    _tile_k = flag_3d ? tile_size_3d : 1;
+    _tiles_i = (N + _tile_i - 1) / _tile_i;
+    _tiles_j = (M + _tile_j - 1) / _tile_j;
+    _tiles_k = (D + _tile_k - 1) / _tile_k;
+
+    _stable_since.resize(totalTiles());
+    _changed.resize(totalTiles());
+    _awake.reserve(totalTiles());
+    wakeAll();
+}
+
+void TileTracker::wakeAll(){
+    std::fill(_stable_since.begin(), _stable_since.end(), _generation);
+}
+
+std::vector<int> &TileTracker::prepare(){
+    _awake.clear();
+    for(int tk = 0; tk < _tiles_k; tk++){
+        for(int ti = 0; ti < _tiles_i; ti++){
+            for(int tj = 0; tj < _tiles_j; tj++){
+                // with the 2D rule the halo doesn't cross planes
+                bool awake = false;
+                for(int dk = _flag_3d ? -1 : 0; dk <= (_flag_3d ? 1 : 0) && !awake; dk++){
+                    for(int di = -1; di <= 1 && !awake; di++){
+                        for(int dj = -1; dj <= 1 && !awake; dj++){
+                            int nk = (tk + dk + _tiles_k) % _tiles_k, ni = (ti + di + _tiles_i) % _tiles_i, nj = (tj + dj + _tiles_j) % _tiles_j;
+                            awake = _stable_since[(nk * _tiles_i + ni) * _tiles_j + nj] == _generation;
+                        }
+                    }
+                }
+                if(awake) _awake.push_back((tk * _tiles_i + ti) * _tiles_j + tj);
+            }
+        }
+    }
+    std::fill(_changed.begin(), _changed.end(), 0);
+    return _awake;
+}
+
+void TileTracker::finish(){
+    _generation++;
+    for(int tile : _awake){
+        if(_changed[tile]) _stable_since[tile] = _generation;
+    }
+}
+
+int TileTracker::maxTiles(int N, int M, int D){
+    int tiles_2d = ((N + tile_size_2d - 1) / tile_size_2d) * ((M + tile_size_2d - 1) / tile_size_2d) * D;
+    int tiles_3d = ((N + tile_size_3d - 1) / tile_size_3d) * ((M + tile_size_3d - 1) / tile_size_3d) * ((D + tile_size_3d - 1) / tile_size_3d);
+    return std::max(tiles_2d, tiles_3d);
+}
@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
+#include "world_allocator.h"
+
+static const size_t huge_page = 2 << 20;
+
+/** A mapping alive, kept to undo its statistics when it's unmapped */
+struct Mapping
+{
+    char *memory = nullptr;
+    size_t size = 0;
+    bool huge = false, explicit_huge = false;   /* explicit huge pages, or advised to use transparent ones */
+    size_t node_bytes[WorldMemoryStats::max_nodes] = {};
+};
+
+/* worlds are few and large, a fixed table keeps the allocator off the heap */
+static const int max_mappings = 64;
+static Mapping mappings[max_mappings];
+static std::mutex mappings_mutex;
+static std::atomic<int> pinned_threads{0};
+
+/** Reads a number from the first line of a file, -1 if it can't be read */
+static long readNumber(const char *path){
+    long value = -1;
+    if(FILE *file = std::fopen(path, "r")){
+        if(std::fscanf(file, "%ld", &value) != 1) value = -1;
+        std::fclose(file);
+    }
+    return value;
+}
+
+int numaNodes(){
+    static const int nodes = []{
+        int count = 0;
+#ifdef __linux__
+        if(DIR *dir = opendir("/sys/devices/system/node")){
+            while(dirent *entry = readdir(dir)){
+                int node;
+                if(std::sscanf(entry->d_name, "node%d", &node) == 1) count++;
+            }
+            closedir(dir);
+        }
+#endif
+        return count > 0 ? count : 1;
+    }();
+    return nodes;
+}
+
+int cpuNode(int cpu){
+    int node = 0;
+#ifdef __linux__
+    char path[64];
+    std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    if(DIR *dir = opendir(path)){
+        while(dirent *entry = readdir(dir)){
+            if(std::sscanf(entry->d_name, "node%d", &node) == 1) break;
+        }
+        closedir(dir);
+    }
+#endif
+    return node;
+}
+
+bool pinThread(int cpu){
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if(pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) return false;
+    pinned_threads.fetch_add(1, std::memory_order_relaxed);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void recordPlacement(const void *memory, int node, size_t bytes){
+    if(node < 0 || node >= WorldMemoryStats::max_nodes) return;
+    std::lock_guard<std::mutex> lock(mappings_mutex);
+    for(Mapping &mapping : mappings){
+        if(mapping.memory <= memory && memory < mapping.memory + mapping.size){
+            mapping.node_bytes[node] += bytes;
+            return;
+        }
+    }
+}
+
+/**
+ * Bytes of a set of ranges backed by transparent huge pages, from the AnonHugePages of the areas
+ * of /proc/self/smaps they overlap. An area can hold more than a range when the kernel merged it
+ * with its neighbours, its huge pages are counted up to the bytes of the ranges inside it
+ */
+static size_t transparentHugeBytes(const Mapping *ranges, int count){
+    size_t total = 0;
+#ifdef __linux__
+    if(!count) return 0;
+    FILE *file = std::fopen("/proc/self/smaps", "r");
+    if(!file) return 0;
+    char line[512];
+    size_t overlap = 0;
+    while(std::fgets(line, sizeof(line), file)){
+        unsigned long start, end, kb;
+        if(std::sscanf(line, "%lx-%lx ", &start, &end) == 2){
+            overlap = 0;
+            for(int r = 0; r < count; r++){
+                uintptr_t begin = std::max((uintptr_t)start, (uintptr_t)ranges[r].memory);
+                uintptr_t finish = std::min((uintptr_t)end, (uintptr_t)ranges[r].memory + ranges[r].size);
+                if(finish > begin) overlap += finish - begin;
+            }
+        }
+        else if(overlap && std::sscanf(line, "AnonHugePages: %lu kB", &kb) == 1) total += std::min((size_t)kb << 10, overlap);
+    }
+    std::fclose(file);
+#else
+    (void)ranges, (void)count;
+#endif
+    return total;
+}
+
+WorldMemoryStats worldMemoryStats(){
+    WorldMemoryStats stats;
+    Mapping transparent[max_mappings];
+    int transparent_count = 0;
+    {
+        std::lock_guard<std::mutex> lock(mappings_mutex);
+        for(const Mapping &mapping : mappings){
+            if(!mapping.memory) continue;
+            stats.bytes += mapping.size;
+            stats.explicit_huge_bytes += mapping.explicit_huge ? mapping.size : 0;
+            if(mapping.huge && !mapping.explicit_huge) transparent[transparent_count++] = mapping;
+            stats.mappings++;
+            for(int node = 0; node < WorldMemoryStats::max_nodes; node++) stats.node_bytes[node] += mapping.node_bytes[node];
+        }
+    }
+    // the advice only allows transparent huge pages, the kernel may never back the world with them
+    stats.huge_bytes = stats.explicit_huge_bytes + transparentHugeBytes(transparent, transparent_count);
+    stats.nodes = numaNodes();
+    stats.pinned_threads = pinned_threads.load(std::memory_order_relaxed);
+    return stats;
+}
+
+/** Keeps a new mapping in the table, mappings past its size are not counted */
+static void addMapping(void *memory, size_t size, bool huge, bool explicit_huge){
+    std::lock_guard<std::mutex> lock(mappings_mutex);
+    for(Mapping &mapping : mappings){
+        if(mapping.memory) continue;
+        mapping = Mapping();
+        mapping.memory = (char*)memory, mapping.size = size;
+        mapping.huge = huge, mapping.explicit_huge = explicit_huge;
+        return;
+    }
+}
+
+/** Removes a mapping from the table */
+static void removeMapping(void *memory){
+    std::lock_guard<std::mutex> lock(mappings_mutex);
+    for(Mapping &mapping : mappings){
+        if(mapping.memory == memory) mapping = Mapping();
+    }
+}
+
+/** Size of a mapping, worlds of a huge page or more take whole huge pages */
+static size_t mappedSize(size_t bytes){
+    return bytes >= huge_page ? (bytes + huge_page - 1) / huge_page * huge_page : bytes;
+}
+
+void *mapWorld(size_t bytes){
+    const size_t size = mappedSize(bytes ? bytes : 1);
+    void *memory = nullptr;
+#ifdef __linux__
+    bool huge = false, explicit_huge = false;
+    if(size >= huge_page){
+        // explicit huge pages only exist if the administrator reserved them
+        static const bool reserved = readNumber("/proc/sys/vm/nr_hugepages") > 0;
+        if(reserved){
+            memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if(memory == MAP_FAILED) memory = nullptr;
+            else huge = explicit_huge = true;
+        }
+        if(!memory){
+            // a huge page more to align the world to one, transparent huge pages need it
+            char *raw = (char*)mmap(nullptr, size + huge_page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(raw == MAP_FAILED) throw std::bad_alloc();
+            char *aligned = (char*)(((uintptr_t)raw + huge_page - 1) / huge_page * huge_page);
+            if(aligned > raw) munmap(raw, aligned - raw);
+            munmap(aligned + size, raw + huge_page - aligned);
+            memory = aligned;
+            huge = madvise(memory, size, MADV_HUGEPAGE) == 0;
+        }
+    }
+    else{
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(memory == MAP_FAILED) throw std::bad_alloc();
+    }
+#else
+    bool huge = false, explicit_huge = false;
+    const size_t alignment = size >= huge_page ? huge_page : 64;
+    memory = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if(!memory) throw std::bad_alloc();
+    std::memset(memory, 0, size);
+#endif
+    addMapping(memory, size, huge, explicit_huge);
+    return memory;
+}
+
+void unmapWorld(void *memory, size_t bytes){
+    if(!memory) return;
+    const size_t size = mappedSize(bytes ? bytes : 1);
+    removeMapping(memory);
+#ifdef __linux__
+    munmap(memory, size);
+#else
+    std::free(memory);
+#endif
+}
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "distributed_conway.h"
+
+/* commands of rank 0 */
+enum { op_load, op_step, op_gather, op_quit };
+
+/* tags of the messages, a halo is tagged with the direction it travels */
+enum { tag_up, tag_down, tag_command, tag_slab };
+
+static double secondsSince(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+DistributedEngine::DistributedEngine(Transport &transport) : _transport(transport){}
+
+DistributedEngine::~DistributedEngine(){
+    if(_transport.rank() != 0) return;
+    try{
+        broadcast({op_quit, 0, _N, _M, _D, 0});
+    }
+    catch(...){
+        /*the other ranks are gone already*/
+    }
+}
+
+void DistributedEngine::broadcast(const Command &command){
+    for(int rank = 1; rank < _transport.size(); rank++) _transport.isend(rank, tag_command, &command, sizeof(command));
+    _transport.wait();
+}
+
+void DistributedEngine::resize(int N, int M, int D){
+    _N = N, _M = M, _D = D;
+    _active = std::max(1, std::min(_transport.size(), N));
+    _begin = slabBegin(_transport.rank());
+    _rows = slabBegin(_transport.rank() + 1) - _begin;
+    if(_transport.rank() >= _active) _rows = 0;
+
+    size_t slab_size = _rows > 0 ? (size_t)(_rows + 2) * D * M : 0;
+    _current.assign(slab_size, 0);
+    _next.assign(slab_size, 0);
+    _sums.resize(M + 2);
+    _generation = 0;
+    _compute_seconds = _wait_seconds = 0;
+}
+
+void DistributedEngine::packSlab(const std::vector<int> &world, int rank, std::vector<uint8_t> &slab) const{
+    int begin = slabBegin(rank), rows = slabBegin(rank + 1) - begin;
+    slab.resize((size_t)rows * _D * _M);
+    uint8_t *out = slab.data();
+    for(int row = 0; row < rows; row++){
+        for(int k = 0; k < _D; k++){
+            const int *in = &world[((size_t)k * _N + begin + row) * _M];
+            for(int j = 0; j < _M; j++) *out++ = in[j] != 0;
+        }
+    }
+}
+
+void DistributedEngine::load(const std::vector<int> &world, int N, int M, int D){
+    resize(N, M, D);
+    broadcast({op_load, 0, N, M, D, 0});
+
+    /*one slab at a time, so rank 0 only holds one slab of another rank*/
+    for(int rank = 1; rank < _active; rank++){
+        packSlab(world, rank, _scatter);
+        _transport.send(rank, tag_slab, _scatter.data(), _scatter.size());
+    }
+    packSlab(world, 0, _scatter);
+    std::copy(_scatter.begin(), _scatter.end(), _current.begin() + (size_t)_D * _M);
+}
+
+void DistributedEngine::stepRow(int row, int flag_3d){
+    const size_t row_size = (size_t)_D * _M;
+    const uint8_t target = flag_3d ? 5 : 3;
+    const int planes_used = flag_3d ? 3 : 1;
+    uint8_t *sums = _sums.data() + 1;
+
+    for(int k = 0; k < _D; k++){
+        int planes[3] = {k, k == 0 ? _D - 1 : k - 1, k == _D - 1 ? 0 : k + 1};
+
+        std::fill(sums, sums + _M, 0);
+        for(int p = 0; p < planes_used; p++){
+            for(int r = row - 1; r <= row + 1; r++) _kernel.addRow(sums, &_current[r * row_size + (size_t)planes[p] * _M], _M);
+        }
+        sums[-1] = sums[_M - 1];
+        sums[_M] = sums[0];
+
+        size_t offset = row * row_size + (size_t)k * _M;
+        _kernel.applyRule(sums, &_current[offset], &_next[offset], _M, target);
+    }
+}
+
+void DistributedEngine::advance(int generations, int flag_3d){
+    if(_rows == 0) return;
+    const size_t row_size = (size_t)_D * _M;
+    const int rank = _transport.rank();
+    const int up = (rank + _active - 1) % _active, down = (rank + 1) % _active;
+
+    for(int g = 0; g < generations; g++){
+        auto start = std::chrono::steady_clock::now();
+        uint8_t *first = &_current[row_size], *last = &_current[_rows * row_size];
+        uint8_t *upper_halo = &_current[0], *lower_halo = &_current[(_rows + 1) * row_size];
+
+        if(_active == 1){
+            /*the only slab wraps onto itself*/
+            std::memcpy(upper_halo, last, row_size);
+            std::memcpy(lower_halo, first, row_size);
+            for(int row = 1; row <= _rows; row++) stepRow(row, flag_3d);
+            _compute_seconds += secondsSince(start);
+        }
+        else{
+            /*the halos travel while the inner rows are calculated*/
+            _transport.isend(up, tag_up, first, row_size);
+            _transport.isend(down, tag_down, last, row_size);
+            _transport.irecv(up, tag_down, upper_halo, row_size);
+            _transport.irecv(down, tag_up, lower_halo, row_size);
+            for(int row = 2; row < _rows; row++) stepRow(row, flag_3d);
+            _compute_seconds += secondsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            _transport.wait();
+            _wait_seconds += secondsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            stepRow(1, flag_3d);
+            if(_rows > 1) stepRow(_rows, flag_3d);
+            _compute_seconds += secondsSince(start);
+        }
+        _current.swap(_next);
+        _generation++;
+    }
+}
+
+void DistributedEngine::step(int flag_3d){
+    run(1, flag_3d);
+}
+
+void DistributedEngine::run(int generations, int flag_3d){
+    broadcast({op_step, flag_3d, _N, _M, _D, generations});
+    advance(generations, flag_3d);
+}
+
+void DistributedEngine::collectLive(){
+    _live.clear();
+    const size_t plane_size = (size_t)_N * _M;
+    const uint8_t *cell = _current.data() + (size_t)_D * _M;
+    for(int row = 0; row < _rows; row++){
+        for(int k = 0; k < _D; k++){
+            int32_t offset = k * plane_size + (size_t)(_begin + row) * _M;
+            for(int j = 0; j < _M; j++, cell++) if(*cell) _live.push_back(offset + j);
+        }
+    }
+}
+
+void DistributedEngine::store(std::vector<int> &world){
+    broadcast({op_gather, 0, _N, _M, _D, 0});
+    std::fill(world.begin(), world.end(), 0);
+
+    collectLive();
+    for(int32_t index : _live) world[index] = 1;
+    for(int rank = 1; rank < _active; rank++){
+        int64_t count;
+        _transport.recv(rank, tag_slab, &count, sizeof(count));
+        _live.resize(count);
+        _transport.recv(rank, tag_slab, _live.data(), count * sizeof(int32_t));
+        for(int32_t index : _live) world[index] = 1;
+    }
+}
+
+void DistributedEngine::serve(){
+    while(true){
+        Command command;
+        _transport.recv(0, tag_command, &command, sizeof(command));
+        switch(command.op){
+        case op_load:
+            resize(command.N, command.M, command.D);
+            if(_rows > 0) _transport.recv(0, tag_slab, &_current[(size_t)_D * _M], (size_t)_rows * _D * _M);
+            break;
+        case op_step:
+            advance(command.generations, command.flag_3d);
+            break;
+        case op_gather:
+            if(_rows > 0){
+                collectLive();
+                int64_t count = _live.size();
+                _transport.isend(0, tag_slab, &count, sizeof(count));
+                _transport.isend(0, tag_slab, _live.data(), count * sizeof(int32_t));
+                _transport.wait();
+            }
+            break;
+        default:
+            return;
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#include "transport.h"
+
+#ifdef CONWAY_HAVE_MPI
+
+#include <climits>
+#include <stdexcept>
+
+#include <mpi.h>
+
+/** Implements the transport with MPI nonblocking sends and receives */
+class MpiTransport : public Transport
+{
+private:
+    int _rank = 0, _size = 1;
+    std::vector<MPI_Request> _requests;
+
+    void checkSize(size_t bytes){
+        if(bytes > INT_MAX) throw std::runtime_error("Message too large for MPI");
+    }
+
+public:
+    MpiTransport(){
+        int initialized = 0;
+        MPI_Initialized(&initialized);
+        if(!initialized) MPI_Init(nullptr, nullptr);
+        MPI_Comm_rank(MPI_COMM_WORLD, &_rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &_size);
+    }
+
+    ~MpiTransport(){
+        int finalized = 0;
+        MPI_Finalized(&finalized);
+        if(!finalized) MPI_Finalize();
+    }
+
+    int rank() const override { return _rank; }
+
+    int size() const override { return _size; }
+
+    void isend(int to, int tag, const void *data, size_t bytes) override {
+        checkSize(bytes);
+        _requests.emplace_back();
+        MPI_Isend(data, (int)bytes, MPI_BYTE, to, tag, MPI_COMM_WORLD, &_requests.back());
+    }
+
+    void irecv(int from, int tag, void *data, size_t bytes) override {
+        checkSize(bytes);
+        _requests.emplace_back();
+        MPI_Irecv(data, (int)bytes, MPI_BYTE, from, tag, MPI_COMM_WORLD, &_requests.back());
+    }
+
+    void wait() override {
+        MPI_Waitall(_requests.size(), _requests.data(), MPI_STATUSES_IGNORE);
+        _requests.clear();
+    }
+};
+
+std::unique_ptr<Transport> createMpiTransport(){
+    return std::unique_ptr<Transport>(new MpiTransport());
+}
+
+#else
+
+std::unique_ptr<Transport> createMpiTransport(){
+    return nullptr;
+}
+
+#endif
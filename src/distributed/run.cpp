@@ -0,0 +1,103 @@
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "distributed_conway.h"
+#include "sequential_conway.h"
+
+/* Runs a world split in slabs across processes. The ranks are started from the environment
+ * (see createTransportFromEnvironment, e.g. by mpirun with CONWAY_TRANSPORT=mpi), or as local
+ * processes forked by this one and connected by Unix sockets. Rank 0 gathers the live cells
+ * every [frame interval] generations, as the viewer would to draw a frame, and checks the
+ * last generation against the sequential step when the world is small.
+ *
+ * usage: conway_distributed <local ranks> [generations] [rows] [cols] [planes] [2d] [frame interval]
+ */
+
+/* worlds up to this many cells are checked against the sequential step */
+static const size_t max_checked_cells = 1 << 22;
+
+int main(int argc, char **argv){
+    if(argc < 2){
+        std::cerr << "usage: conway_distributed <local ranks> [generations] [rows] [cols] [planes] [2d] [frame interval]" << std::endl;
+        return 1;
+    }
+    int ranks = std::max(1, std::atoi(argv[1]));
+    int generations = argc > 2 ? std::atoi(argv[2]) : 100;
+    int N = argc > 3 ? std::atoi(argv[3]) : 256;
+    int M = argc > 4 ? std::atoi(argv[4]) : N;
+    int D = argc > 5 ? std::atoi(argv[5]) : N;
+    int flag_3d = argc > 6 ? !std::atoi(argv[6]) : 1;
+    int interval = argc > 7 ? std::max(1, std::atoi(argv[7])) : 10;
+
+    std::unique_ptr<Transport> transport = createTransportFromEnvironment();
+    std::vector<pid_t> children;
+    if(!transport){
+        std::string description = "unix:" + (std::filesystem::temp_directory_path() / ("conway_" + std::to_string(getpid()))).string();
+        int rank = 0;
+        for(int r = 1; r < ranks; r++){
+            pid_t pid = fork();
+            if(pid == 0){
+                rank = r;
+                children.clear();
+                break;
+            }
+            children.push_back(pid);
+        }
+        transport = createTransport(description, rank, ranks);
+    }
+    if(!transport){
+        std::cerr << "Invalid CONWAY_TRANSPORT" << std::endl;
+        return 1;
+    }
+
+    int status = 0;
+    {
+        DistributedEngine engine(*transport);
+        if(transport->rank() != 0){
+            engine.serve();
+            return 0;
+        }
+
+        std::vector<int> world((size_t)N * M * D);
+        std::mt19937 generator(42);
+        std::bernoulli_distribution alive(flag_3d ? 0.2 : 0.3);
+        for(int &cell : world) cell = alive(generator);
+        std::vector<int> initial = world;
+
+        std::cout << "World " << N << "x" << M << "x" << D << " on " << engine.ranks() << " ranks" << std::endl;
+        engine.load(world, N, M, D);
+        auto start = std::chrono::steady_clock::now();
+        for(int done = 0; done < generations;){
+            int count = std::min(interval, generations - done);
+            engine.run(count, flag_3d);
+            engine.store(world);
+            done += count;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << generations << " generations in " << seconds << " s, " << (double)world.size() * generations / seconds / 1e6
+                  << " Mcells/s, rank 0 calculated " << engine.computeSeconds() << " s and waited " << engine.waitSeconds()
+                  << " s for halos" << std::endl;
+
+        if(world.size() <= max_checked_cells){
+            std::vector<int> next(initial.size());
+            for(int g = 0; g < generations; g++){
+                calculateStepSequential(initial.data(), next.data(), N, M, D, flag_3d);
+                initial.swap(next);
+            }
+            bool same = initial == world;
+            std::cout << (same ? "Matches" : "Doesn't match") << " the sequential step" << std::endl;
+            status = same ? 0 : 1;
+        }
+    }
+
+    for(pid_t child : children) waitpid(child, nullptr, 0);
+    return status;
+}
@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "transport.h"
+
+/* time a rank waits for the others to start listening */
+static const std::chrono::seconds connect_timeout(30);
+
+/** Address of a socket, Unix or TCP */
+struct SocketAddress {
+    sockaddr_storage storage;
+    socklen_t length = 0;
+    bool unix_socket = false;
+    std::string path;
+};
+
+static SocketAddress parseAddress(const std::string &address){
+    SocketAddress result;
+    std::memset(&result.storage, 0, sizeof(result.storage));
+    if(address.compare(0, 5, "unix:") == 0){
+        result.unix_socket = true;
+        result.path = address.substr(5);
+        sockaddr_un *un = (sockaddr_un*)&result.storage;
+        if(result.path.empty() || result.path.size() >= sizeof(un->sun_path)) throw std::runtime_error("Invalid socket path " + address);
+        un->sun_family = AF_UNIX;
+        std::strcpy(un->sun_path, result.path.c_str());
+        result.length = sizeof(sockaddr_un);
+        return result;
+    }
+
+    size_t colon = address.rfind(':');
+    if(colon == std::string::npos) throw std::runtime_error("Invalid address " + address);
+    addrinfo hints, *info = nullptr;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if(getaddrinfo(address.substr(0, colon).c_str(), address.substr(colon + 1).c_str(), &hints, &info) != 0 || !info)
+        throw std::runtime_error("Can't resolve " + address);
+    std::memcpy(&result.storage, info->ai_addr, info->ai_addrlen);
+    result.length = info->ai_addrlen;
+    freeaddrinfo(info);
+    return result;
+}
+
+/** Reads or writes a whole buffer on a blocking socket, used while connecting */
+static void readAll(int fd, void *data, size_t bytes){
+    for(size_t done = 0; done < bytes;){
+        ssize_t n = ::read(fd, (char*)data + done, bytes - done);
+        if(n <= 0) throw std::runtime_error("Connection closed while connecting");
+        done += n;
+    }
+}
+
+static void writeAll(int fd, const void *data, size_t bytes){
+    for(size_t done = 0; done < bytes;){
+        ssize_t n = ::write(fd, (const char*)data + done, bytes - done);
+        if(n <= 0) throw std::runtime_error("Connection closed while connecting");
+        done += n;
+    }
+}
+
+SocketTransport::SocketTransport(int rank, const std::vector<std::string> &addresses) : _rank(rank), _size(addresses.size()), _peers(addresses.size()){
+    if(rank < 0 || rank >= _size) throw std::runtime_error("Rank out of range");
+    if(_size == 1) return;
+
+    /*listens on its own address for the ranks after it*/
+    SocketAddress own = parseAddress(addresses[rank]);
+    int listener = socket(own.storage.ss_family, SOCK_STREAM, 0);
+    int yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    if(own.unix_socket) unlink(own.path.c_str());
+    if(listener < 0 || bind(listener, (sockaddr*)&own.storage, own.length) != 0 || listen(listener, _size) != 0){
+        if(listener >= 0) ::close(listener);
+        throw std::runtime_error("Can't listen on " + addresses[rank]);
+    }
+
+    /*connects to the ranks before it, retrying until they listen*/
+    for(int peer = 0; peer < rank; peer++){
+        SocketAddress address = parseAddress(addresses[peer]);
+        auto deadline = std::chrono::steady_clock::now() + connect_timeout;
+        int fd = -1;
+        while(true){
+            fd = socket(address.storage.ss_family, SOCK_STREAM, 0);
+            if(fd >= 0 && connect(fd, (sockaddr*)&address.storage, address.length) == 0) break;
+            if(fd >= 0) ::close(fd);
+            if(std::chrono::steady_clock::now() > deadline){
+                ::close(listener);
+                throw std::runtime_error("Can't connect to " + addresses[peer]);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        int32_t id = rank;
+        writeAll(fd, &id, sizeof(id));
+        _peers[peer].fd = fd;
+    }
+
+    /*accepts the ranks after it, they tell their rank first*/
+    for(int accepted = rank + 1; accepted < _size; accepted++){
+        int fd = accept(listener, nullptr, nullptr);
+        if(fd < 0){
+            ::close(listener);
+            throw std::runtime_error("Accept failed on " + addresses[rank]);
+        }
+        int32_t id;
+        readAll(fd, &id, sizeof(id));
+        if(id <= rank || id >= _size || _peers[id].fd >= 0) throw std::runtime_error("Unexpected rank connected");
+        _peers[id].fd = fd;
+    }
+    ::close(listener);
+    if(own.unix_socket) unlink(own.path.c_str());
+
+    for(Peer &peer : _peers){
+        if(peer.fd < 0) continue;
+        if(!own.unix_socket) setsockopt(peer.fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        fcntl(peer.fd, F_SETFL, fcntl(peer.fd, F_GETFL) | O_NONBLOCK);
+    }
+    _polls.reserve(_size);
+}
+
+SocketTransport::~SocketTransport(){
+    for(Peer &peer : _peers) if(peer.fd >= 0) ::close(peer.fd);
+}
+
+bool SocketTransport::writeSends(Peer &peer){
+    while(!peer.sends.empty()){
+        Send &send = peer.sends.front();
+        size_t total = sizeof(Header) + send.header.bytes;
+        while(send.done < total){
+            ssize_t n;
+            if(send.done < sizeof(Header)){
+                iovec parts[2] = {{(char*)&send.header + send.done, sizeof(Header) - send.done}, {(void*)send.data, send.header.bytes}};
+                n = ::writev(peer.fd, parts, 2);
+            }
+            else n = ::send(peer.fd, send.data + send.done - sizeof(Header), total - send.done, MSG_NOSIGNAL);
+            if(n < 0){
+                if(errno == EAGAIN || errno == EWOULDBLOCK) return false;
+                if(errno == EINTR) continue;
+                throw std::runtime_error("Send failed");
+            }
+            send.done += n;
+        }
+        peer.sends.pop_front();
+    }
+    return true;
+}
+
+bool SocketTransport::readMessages(Peer &peer){
+    while(!peer.receives.empty() || peer.done > 0){
+        /*header, then the message into its receive or into unexpected*/
+        size_t total = peer.done < sizeof(Header) ? sizeof(Header) : sizeof(Header) + peer.header.bytes;
+        if(peer.done < total){
+            char *to = peer.done < sizeof(Header) ? (char*)&peer.header + peer.done : peer.target + peer.done - sizeof(Header);
+            ssize_t n = ::read(peer.fd, to, total - peer.done);
+            if(n == 0) throw std::runtime_error("Connection closed");
+            if(n < 0){
+                if(errno == EAGAIN || errno == EWOULDBLOCK) return false;
+                if(errno == EINTR) continue;
+                throw std::runtime_error("Receive failed");
+            }
+            peer.done += n;
+            if(peer.done < total) continue;
+        }
+
+        if(peer.done == sizeof(Header) && !peer.target){
+            auto receive = std::find_if(peer.receives.begin(), peer.receives.end(), [&](const Receive &r){ return r.tag == peer.header.tag; });
+            peer.matched = receive != peer.receives.end();
+            if(peer.matched){
+                if(receive->bytes != peer.header.bytes) throw std::runtime_error("Message size doesn't match its receive");
+                peer.target = receive->data;
+                peer.receives.erase(receive);
+            }
+            else{
+                peer.unexpected.push_back({peer.header.tag, std::vector<char>(peer.header.bytes)});
+                peer.target = peer.unexpected.back().data.data();
+            }
+            if(peer.header.bytes > 0) continue;
+        }
+
+        /*message complete*/
+        peer.done = 0;
+        peer.target = nullptr;
+    }
+    return true;
+}
+
+void SocketTransport::isend(int to, int tag, const void *data, size_t bytes){
+    Peer &peer = _peers[to];
+    peer.sends.push_back({{tag, 0, bytes}, (const char*)data, 0});
+    if(peer.sends.size() == 1) writeSends(peer);
+}
+
+void SocketTransport::irecv(int from, int tag, void *data, size_t bytes){
+    Peer &peer = _peers[from];
+    auto message = std::find_if(peer.unexpected.begin(), peer.unexpected.end(), [&](const Message &m){ return m.tag == tag; });
+    if(message != peer.unexpected.end()){
+        if(message->data.size() != bytes) throw std::runtime_error("Message size doesn't match its receive");
+        std::memcpy(data, message->data.data(), bytes);
+        peer.unexpected.erase(message);
+        return;
+    }
+    peer.receives.push_back({tag, (char*)data, bytes});
+}
+
+void SocketTransport::wait(){
+    while(true){
+        _polls.clear();
+        for(Peer &peer : _peers){
+            if(peer.fd < 0) continue;
+            short events = 0;
+            if(!writeSends(peer)) events |= POLLOUT;
+            if(!readMessages(peer)) events |= POLLIN;
+            if(events) _polls.push_back({peer.fd, events, 0});
+        }
+        if(_polls.empty()) return;
+        if(poll(_polls.data(), _polls.size(), -1) < 0 && errno != EINTR) throw std::runtime_error("Poll failed");
+    }
+}
+
+std::unique_ptr<Transport> createTransport(const std::string &description, int rank, int size){
+    if(description == "mpi") return createMpiTransport();
+    if(size < 1 || rank < 0 || rank >= size) return nullptr;
+
+    std::vector<std::string> addresses;
+    if(description.compare(0, 5, "unix:") == 0){
+        for(int r = 0; r < size; r++) addresses.push_back(description + "." + std::to_string(r));
+    }
+    else if(description.compare(0, 4, "tcp:") == 0){
+        std::string list = description.substr(4);
+        if(list.find(',') == std::string::npos){
+            size_t colon = list.rfind(':');
+            if(colon == std::string::npos) return nullptr;
+            int port = std::atoi(list.c_str() + colon + 1);
+            if(port <= 0) return nullptr;
+            for(int r = 0; r < size; r++) addresses.push_back(list.substr(0, colon + 1) + std::to_string(port + r));
+        }
+        else{
+            for(size_t begin = 0; begin <= list.size();){
+                size_t end = std::min(list.find(',', begin), list.size());
+                addresses.push_back(list.substr(begin, end - begin));
+                begin = end + 1;
+            }
+            if((int)addresses.size() != size) return nullptr;
+        }
+    }
+    else return nullptr;
+    return std::unique_ptr<Transport>(new SocketTransport(rank, addresses));
+}
+
+std::unique_ptr<Transport> createTransportFromEnvironment(){
+    const char *description = std::getenv("CONWAY_TRANSPORT");
+    if(!description) return nullptr;
+    const char *rank = std::getenv("CONWAY_RANK"), *size = std::getenv("CONWAY_RANKS");
+    return createTransport(description, rank ? std::atoi(rank) : 0, size ? std::atoi(size) : 1);
+}
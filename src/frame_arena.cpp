@@ -0,0 +1,51 @@
+#include <algorithm>
+#include <iterator>
+
+#include "frame_arena.h"
+
+void *FrameArena::Overflow::do_allocate(size_t bytes, size_t alignment){
+    this->bytes += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void FrameArena::Overflow::do_deallocate(void *memory, size_t bytes, size_t alignment){
+    std::pmr::new_delete_resource()->deallocate(memory, bytes, alignment);
+}
+
+FrameArena::FrameArena(size_t bytes) : _buffer(bytes){
+    _resource.emplace(_buffer.data(), _buffer.size(), &_overflow);
+}
+
+void *FrameArena::do_allocate(size_t bytes, size_t alignment){
+    _used += bytes;
+    return _resource->allocate(bytes, alignment);
+}
+
+void FrameArena::reset(){
+    // the monotonic resource gives back what it took from the heap when it's destroyed
+    _resource.reset();
+    _peak = std::max(_peak, _used);
+
+    if(_overflow.bytes){
+        // room for the frame that didn't fit and as much again, so slowly growing frames don't grow it every time
+        _buffer = std::vector<std::byte>(2 * (_buffer.size() + _overflow.bytes));
+        _grown++;
+    }
+    _overflow.bytes = 0;
+    _used = 0;
+    _resource.emplace(_buffer.data(), _buffer.size(), &_overflow);
+}
+
+int gatherLiveCells(const std::vector<int> &world, const std::vector<float> &coords, size_t cells, std::pmr::vector<float> &positions){
+    int live = std::count_if(world.begin(), world.begin() + cells, [](int cell){ return cell != 0; });
+
+    // sized once for every live cell
+    positions.clear();
+    positions.reserve((size_t)live * 3);
+    for(size_t i = 0; i < cells; i++){
+        if(world[i]){
+            positions.insert(positions.end(), {coords[i*3], coords[i*3 + 1], coords[i*3 + 2]});
+        }
+    }
+    return live;
+}
@@ -24,8 +24,9 @@ int worldIdx(int i, int j, int k, const int N, const int M, const int D){
 */
 __kernel void calcStep(global int *current, global int *next, int N, int M, int D, int flag_3d){
 
-    // global position
+    // global position, the range is rounded up to whole groups
     int gindex = get_global_id(0);
+    if(gindex >= N * M * D) return;
 
     // global position in 3 dimensions  
     int k = gindex / (N * M);  
@@ -0,0 +1,90 @@
+/** 
+    Wraps a coordinate into the world, windows wider than the world go around it more than once
+    @param x coordinate to wrap
+    @param size size of the axis
+*/
+inline int wrapAxis(int x, int size){
+    x %= size;
+    return x < 0 ? x + size : x;
+}
+
+/** 
+    Applies a Larger than Life rule to a cell
+    @param count live cells in the box of the cell, including the cell
+    @param cell state of the cell
+*/
+inline int ltlCell(int count, int cell, int bmin, int bmax, int smin, int smax, int center){
+    if(!center) count -= cell;
+    return cell ? (count >= smin && count <= smax) : (count >= bmin && count <= bmax);
+}
+
+/** 
+    Calculates a pass of a step of a Larger than Life rule, every thread slides a window along
+    a line of the world so the cost per cell doesn't depend on the radius
+    pass 0 sums the rows, one thread per row
+    pass 1 sums the columns of the row sums, one thread per column, and in 2D applies the rule
+    pass 2 sums the planes of the column sums, one thread per cell of a plane, and applies the rule
+    @param current global array representing current state of world
+    @param next global array representing next state of world
+    @param rows global array holding the sums along the rows
+    @param columns global array holding the sums along the rows and columns
+    @param N size of world's x axis
+    @param M size of world's y axis
+    @param D size of world's z axis
+    @param flag_3d if true the box is a cube across planes
+    @param R radius of the box
+    @param bmin, bmax range of counts that give birth
+    @param smin, smax range of counts that keep a cell alive
+    @param center if true the count includes the cell itself
+    @param pass pass of the step
+*/
+__kernel void calcStep(global const int *current, global int *next, global int *rows, global int *columns,
+                       int N, int M, int D, int flag_3d, int R, int bmin, int bmax, int smin, int smax, int center, int pass){
+    int gindex = get_global_id(0);
+
+    if(pass == 0){
+        if(gindex >= N * D) return;
+        global const int *cells = current + gindex * M;
+        global int *out = rows + gindex * M;
+
+        int sum = 0;
+        for(int d = -R; d <= R; d++) sum += cells[wrapAxis(d, M)];
+        out[0] = sum;
+        for(int j = 1; j < M; j++){
+            sum += cells[wrapAxis(j + R, M)] - cells[wrapAxis(j - R - 1, M)];
+            out[j] = sum;
+        }
+    }
+    else if(pass == 1){
+        // consecutive threads read consecutive columns
+        if(gindex >= M * D) return;
+        int k = gindex / M;
+        int j = gindex % M;
+        global const int *in = rows + k * N * M + j;
+        global int *out = columns + k * N * M + j;
+
+        int sum = 0;
+        for(int d = -R; d <= R; d++) sum += in[wrapAxis(d, N) * M];
+        for(int i = 0; i < N; i++){
+            if(i > 0) sum += in[wrapAxis(i + R, N) * M] - in[wrapAxis(i - R - 1, N) * M];
+            if(flag_3d) out[i * M] = sum;
+            else{
+                int index = (k * N + i) * M + j;
+                next[index] = ltlCell(sum, current[index], bmin, bmax, smin, smax, center);
+            }
+        }
+    }
+    else{
+        // consecutive threads read consecutive cells of a plane
+        if(gindex >= N * M) return;
+        int plane_size = N * M;
+
+        int sum = 0;
+        for(int d = -R; d <= R; d++) sum += columns[wrapAxis(d, D) * plane_size + gindex];
+        for(int k = 0; k < D; k++){
+            if(k > 0) sum += columns[wrapAxis(k + R, D) * plane_size + gindex] - columns[wrapAxis(k - R - 1, D) * plane_size + gindex];
+            int index = k * plane_size + gindex;
+            next[index] = ltlCell(sum, current[index], bmin, bmax, smin, smax, center);
+        }
+    }
+}
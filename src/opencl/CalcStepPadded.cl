@@ -0,0 +1,120 @@
+/**
+    Gets the coordinate of the cell a ghost cell copies on an axis
+    @param x coordinate, from -1 to size
+    @param size size of the axis
+    @param boundary 0 wraps around the world, 1 dead cells, 2 reflects the edges
+    @return coordinate of the cell, -1 if the ghost cell is dead
+*/
+inline int haloSource(int x, int size, int boundary){
+    if(x >= 0 && x < size) return x;
+    if(boundary == 0) return x < 0 ? size - 1 : 0;
+    if(boundary == 2) return x < 0 ? 0 : size - 1;
+    return -1;
+}
+
+/**
+    Gets the coordinates of a ghost cell, the halo is numbered by faces: the halo columns of the
+    rows of the world, then the halo rows of its planes and, in 3D, the two halo planes
+    @param h index of the ghost cell
+    @param N size of world's x axis
+    @param M size of world's y axis
+    @param D size of world's z axis
+    @param flag_3d if false the halo planes are not numbered, they are never read
+    @param i row of the ghost cell, from -1 to N
+    @param j column of the ghost cell, from -1 to M
+    @param k plane of the ghost cell, from -1 to D
+    @return false if h is past the last ghost cell
+*/
+inline bool haloCell(int h, int N, int M, int D, int flag_3d, int *i, int *j, int *k){
+    int columns = 2 * N * D, rows = 2 * (M + 2) * D, planes = flag_3d ? 2 * (N + 2) * (M + 2) : 0;
+    if(h < columns){
+        *j = h % 2 ? M : -1;
+        *i = h / 2 % N;
+        *k = h / 2 / N;
+        return true;
+    }
+    h -= columns;
+    if(h < rows){
+        *j = h % (M + 2) - 1;
+        *i = h / (M + 2) % 2 ? N : -1;
+        *k = h / (M + 2) / 2;
+        return true;
+    }
+    h -= rows;
+    if(h < planes){
+        *j = h % (M + 2) - 1;
+        *i = h / (M + 2) % (N + 2) - 1;
+        *k = h / (M + 2) / (N + 2) ? D : -1;
+        return true;
+    }
+    return false;
+}
+
+/**
+    Calculates the next state of a cell of a padded world, reading its neighbours with plain offsets
+    @param center the cell in the padded world
+    @param pitch cells from a padded row to the next one
+    @param plane_size cells from a padded plane to the next one
+    @param flag_3d if true counts the neighbours across planes
+*/
+inline int nextState(global const int *center, int pitch, int plane_size, int flag_3d){
+    int neighbours = center[-pitch - 1] + center[-pitch] + center[-pitch + 1] +
+                     center[-1] + center[1] +
+                     center[pitch - 1] + center[pitch] + center[pitch + 1];
+    int cell = center[0];
+    if(flag_3d){
+        for(int p = -plane_size; p <= plane_size; p += 2 * plane_size){
+            global const int *plane = center + p;
+            neighbours += plane[-pitch - 1] + plane[-pitch] + plane[-pitch + 1] +
+                          plane[-1] + plane[0] + plane[1] +
+                          plane[pitch - 1] + plane[pitch] + plane[pitch + 1];
+        }
+        return cell ? (neighbours == 4 || neighbours == 5) : neighbours == 5;
+    }
+    return neighbours == 3 || (neighbours == 2 && cell);
+}
+
+/**
+    Calculates a pass of a step on worlds with a halo of ghost cells, rows of the padded worlds
+    start every pitch cells and planes every (N + 2) * pitch cells. The world stays padded between
+    steps, only the halo is written apart from the cells
+    pass 0 calculates the next state of the cells, one thread per cell on a 3D range of columns, rows and planes
+    pass 1 calculates the next state of the halo, every ghost cell takes the next state of the cell it copies, one thread per ghost cell
+    pass 2 fills the halo of the current world from its cells, after it was copied in, one thread per ghost cell
+    @param current global array holding the current state of the padded world
+    @param next global array that will hold the next state of the padded world
+    @param N size of world's x axis
+    @param M size of world's y axis
+    @param D size of world's z axis
+    @param pitch cells from a padded row to the next one
+    @param flag_3d if true counts the neighbours across planes
+    @param boundary what the halo holds, 0 the opposite edge, 1 dead cells, 2 the edge itself
+    @param pass pass of the step
+*/
+__kernel void calcStep(global int *current, global int *next,
+                       int N, int M, int D, int pitch, int flag_3d, int boundary, int pass){
+    int plane_size = (N + 2) * pitch;
+
+    if(pass == 0){
+        int j = get_global_id(0), i = get_global_id(1), k = get_global_id(2);
+        if(j >= M || i >= N) return;
+        int index = (k + 1) * plane_size + (i + 1) * pitch + j + 1;
+        next[index] = nextState(current + index, pitch, plane_size, flag_3d);
+        return;
+    }
+
+    int i, j, k;
+    if(!haloCell(get_global_id(0), N, M, D, flag_3d, &i, &j, &k)) return;
+    int index = (k + 1) * plane_size + (i + 1) * pitch + j + 1;
+
+    // in 2D the halo rows and columns of a plane copy cells of the same plane
+    int si = haloSource(i, N, boundary), sj = haloSource(j, M, boundary), sk = flag_3d ? haloSource(k, D, boundary) : k;
+    if(si < 0 || sj < 0 || sk < 0){
+        if(pass == 1) next[index] = 0;
+        else current[index] = 0;
+        return;
+    }
+    int source = (sk + 1) * plane_size + (si + 1) * pitch + sj + 1;
+    if(pass == 1) next[index] = nextState(current + source, pitch, plane_size, flag_3d);
+    else current[index] = current[source];
+}
@@ -0,0 +1,68 @@
+/* Built with -D options for every configuration:
+    N, M, D size of world's x, y and z axis
+    BIRTH, SURVIVE masks of the rule, bit n set if n neighbours give birth or keep a cell alive
+    DIMS 2 applies the rule on every plane on its own, 3 counts neighbours across planes
+    VON_NEUMANN 1 counts only the neighbours sharing a side, 0 every adjacent one
+    BOUNDARY 0 wraps around the world, 1 treats the cells outside of it as dead, 2 reflects the edges
+*/
+
+/** 
+    Gets a cell of the world, coordinates are at most one cell outside of it
+    @param current global array representing current state of world
+    @param i position on x axis
+    @param j position on y axis
+    @param k position on z axis
+*/
+inline int cellAt(global const int *current, int i, int j, int k){
+#if BOUNDARY == 0
+    i = i < 0 ? i + N : (i >= N ? i - N : i);
+    j = j < 0 ? j + M : (j >= M ? j - M : j);
+    k = k < 0 ? k + D : (k >= D ? k - D : k);
+#elif BOUNDARY == 2
+    i = clamp(i, 0, N - 1);
+    j = clamp(j, 0, M - 1);
+    k = clamp(k, 0, D - 1);
+#else
+    if(i < 0 || i >= N || j < 0 || j >= M || k < 0 || k >= D) return 0;
+#endif
+    return current[(k * N + i) * M + j];
+}
+
+/** 
+    Calculates a step of a Life-like rule, everything but the cells is known at compile time
+    @param current global array representing current state of world
+    @param next global array representing next state of world
+*/
+__kernel void calcStep(global const int *current, global int *next){
+    int gindex = get_global_id(0);
+    if(gindex >= N * M * D) return;
+
+    int k = gindex / (N * M);
+    int i = (gindex / M) % N;
+    int j = gindex % M;
+    int cell = current[gindex];
+
+#if VON_NEUMANN
+    int neighbours = cellAt(current, i - 1, j, k) + cellAt(current, i + 1, j, k) + cellAt(current, i, j - 1, k) + cellAt(current, i, j + 1, k);
+#if DIMS == 3
+    neighbours += cellAt(current, i, j, k - 1) + cellAt(current, i, j, k + 1);
+#endif
+#else
+    int neighbours = -cell;
+#if DIMS == 3
+    #pragma unroll
+    for(int dk = -1; dk <= 1; dk++)
+#else
+    const int dk = 0;
+#endif
+    {
+        #pragma unroll
+        for(int di = -1; di <= 1; di++){
+            #pragma unroll
+            for(int dj = -1; dj <= 1; dj++) neighbours += cellAt(current, i + di, j + dj, k + dk);
+        }
+    }
+#endif
+
+    next[gindex] = ((cell ? SURVIVE : BIRTH) >> neighbours) & 1;
+}
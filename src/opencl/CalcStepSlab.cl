@@ -0,0 +1,47 @@
+/** 
+    Calculates a step on a slab of planes of a world split across devices. The halo planes, copies
+    of the last plane of the slab before it and the first plane of the slab after it, are held in
+    a buffer of their own, so they can be written while other planes of the slab are calculated,
+    and planes are not wrapped. Rows and columns wrap as usual.
+    The threads calculate count planes starting at first_plane and separated by plane_step, so the
+    planes that don't need the halos can run while the halos are copied
+    @param current global array holding the slab
+    @param halo global array holding the plane before the slab and the plane after it
+    @param next global array that will hold the next state of the slab
+    @param N size of world's x axis
+    @param M size of world's y axis
+    @param planes planes of the slab
+    @param flag_3d if true counts the neighbours across planes
+    @param first_plane first plane calculated, from 0 to planes - 1
+    @param plane_step planes from a plane calculated to the next one
+    @param count planes calculated
+*/
+__kernel void calcStep(global const int *current, global const int *halo, global int *next, int N, int M, int planes, int flag_3d,
+                       int first_plane, int plane_step, int count){
+    int gindex = get_global_id(0);
+    int plane_size = N * M;
+    if(gindex >= plane_size * count) return;
+
+    int k = first_plane + gindex / plane_size * plane_step;
+    int i = (gindex % plane_size) / M;
+    int j = gindex % M;
+
+    // rows and columns around the cell, wrapped
+    int rows[3] = {(i + N - 1) % N * M, i * M, (i + 1) % N * M};
+    int cols[3] = {(j + M - 1) % M, j, (j + 1) % M};
+
+    int neighbours = 0;
+    for(int dk = flag_3d ? -1 : 0; dk <= (flag_3d ? 1 : 0); dk++){
+        int p = k + dk;
+        global const int *plane = p < 0 ? halo : p >= planes ? halo + plane_size : current + p * plane_size;
+        for(int r = 0; r < 3; r++){
+            for(int c = 0; c < 3; c++) neighbours += plane[rows[r] + cols[c]];
+        }
+    }
+    int index = k * plane_size + i * M + j;
+    int cell = current[index];
+    neighbours -= cell;
+
+    // same rule as (neighbours | cell) == target, 3 in 2D and 5 in 3D
+    next[index] = (neighbours | cell) == (flag_3d ? 5 : 3);
+}
@@ -0,0 +1,71 @@
+/** 
+    Calculates 1d coordinates from 3d coordinates
+    @param i position on x axis
+    @param j position on y axis
+    @param k position on z axis
+    @param N size of x axis
+    @param M size of y axis
+    @param D size of z axis
+*/
+int worldIdx(int i, int j, int k, const int N, const int M, const int D){
+    k = (k + D) % D;
+    i = (i + N) % N;
+    j = (j + M) % M;
+	return k * N * M + i * M + j;
+}
+
+/** 
+    Calculates a step on conway's game of life only on the awake tiles,
+    cells of sleeping tiles are not written
+    @param current global array representing current state of world
+    @param next global array representing next state of world
+    @param awake list of the tiles to calculate
+    @param changed per tile flag, set if any cell of the tile changed
+    @param N size of world's x axis
+    @param M size of world's y axis
+    @param D size of world's z axis
+    @param flag_3d if true treats the world as 3D
+    @param TI size of a tile on x axis
+    @param TJ size of a tile on y axis
+    @param TK size of a tile on z axis
+*/
+__kernel void calcStep(global int *current, global int *next, global int *awake, global int *changed,
+                        int N, int M, int D, int flag_3d, int TI, int TJ, int TK){
+
+    // tile of this thread and position inside of it
+    int tile_cells = TI * TJ * TK;
+    int tile = awake[get_global_id(0) / tile_cells];
+    int cell = get_global_id(0) % tile_cells;
+
+    int tiles_i = (N + TI - 1) / TI, tiles_j = (M + TJ - 1) / TJ;
+    int tk = tile / (tiles_i * tiles_j), ti = (tile / tiles_j) % tiles_i, tj = tile % tiles_j;
+
+    // global position in 3 dimensions, tiles on the borders can be incomplete
+    int k = tk * TK + cell / (TI * TJ);
+    int i = ti * TI + (cell / TJ) % TI;
+    int j = tj * TJ + cell % TJ;
+    if(i >= N || j >= M || k >= D) return;
+    int gindex = k * N * M + i * M + j;
+
+    //get number of neighbours
+    int neighbours = current[worldIdx(i - 1, j - 1, k, N, M, D)] + current[worldIdx(i - 1, j, k, N, M, D)] + current[worldIdx(i - 1, j + 1, k, N, M, D)] + // same k
+                    current[worldIdx(i, j - 1, k, N, M, D)] + current[worldIdx(i, j + 1, k, N, M, D)] +
+                    current[worldIdx(i + 1, j - 1, k, N, M, D)] + current[worldIdx(i + 1, j, k, N, M, D)] + current[worldIdx(i + 1, j + 1, k, N, M, D)];
+    int alive;
+    if(flag_3d){
+        neighbours +=   current[worldIdx(i - 1, j - 1, k+1, N, M, D)] + current[worldIdx(i - 1, j, k+1, N, M, D)] + current[worldIdx(i - 1, j + 1, k+1, N, M, D)] + // next k
+                        current[worldIdx(i, j - 1, k+1, N, M, D)] + current[worldIdx(i, j + 1, k+1, N, M, D)] + current[worldIdx(i, j, k+1, N, M, D)] +
+                        current[worldIdx(i + 1, j - 1, k+1, N, M, D)] + current[worldIdx(i + 1, j, k+1, N, M, D)] + current[worldIdx(i + 1, j + 1, k+1, N, M, D)] +
+                        current[worldIdx(i - 1, j - 1, k-1, N, M, D)] + current[worldIdx(i - 1, j, k-1, N, M, D)] + current[worldIdx(i - 1, j + 1, k-1, N, M, D)] + // last k
+                        current[worldIdx(i, j - 1, k-1, N, M, D)] + current[worldIdx(i, j + 1, k-1, N, M, D)] + current[worldIdx(i, j, k-1, N, M, D)] +
+                        current[worldIdx(i + 1, j - 1, k-1, N, M, D)] + current[worldIdx(i + 1, j, k-1, N, M, D)] + current[worldIdx(i + 1, j + 1, k-1, N, M, D)];
+        alive = current[gindex] && (4 <= neighbours && neighbours <= 5) || !current[gindex] && neighbours == 5;
+    }
+    else{
+        alive = neighbours == 3 || (neighbours == 2 && current[gindex]);
+    }
+
+    //every thread that sees a change writes the same flag
+    if(alive != current[gindex]) changed[tile] = 1;
+    next[gindex] = alive;
+}
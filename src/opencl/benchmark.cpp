@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "alloc_counter.h"
+#include "opencl_conway.h"
+#include "sequential_conway.h"
+#include "rule_conway.h"
+#include "ltl_conway.h"
+#include "tile_tracker.h"
+
+/* Runs the OpenCL kernels that calculate the whole world on the same random world, reports
+ * their speed and checks their results against the same step on the host: the sequential step,
+ * calculateStepRule for the kernel generated for a rule, on every boundary and with both
+ * neighbourhoods, and for the kernel of the world with ghost cells, copied in and out with its
+ * halo, and LtlEngine for the Larger than Life kernel, with a box wider than the small worlds.
+ * The world split across devices runs on one device and on two slabs of the same one. The other
+ * kernels run twice: copying the world in and out on every step, and keeping it on the
+ * device between the first upload and the last download, with the frames of the window: every
+ * generation is enqueued by a StepPipeline while the one before it is read. The kernel of the
+ * awake tiles runs on a world whose second half starts empty, for enough generations for its
+ * tiles to sleep and wake again. Small worlds whose sizes aren't multiples of the work-groups
+ * are checked too. The exit code is 1 if any kernel differs from the host, or if a frame on the
+ * device allocates after the first one. Kernels are read from kernel/, it has to run from bin.
+ *
+ * usage: conway_opencl_benchmark [rows] [cols] [planes] [generations] [3d]
+ */
+
+/** Fills a world of the given size with random cells */
+static std::vector<int> randomWorld(int N, int M, int D, int flag_3d, std::mt19937 &gen){
+    std::vector<int> world((size_t)N * M * D);
+    std::bernoulli_distribution alive(flag_3d ? 0.15 : 0.3);
+    for(auto &cell : world) cell = alive(gen);
+    return world;
+}
+
+/** Runs generations of the sequential step, the reference of the kernels */
+static std::vector<int> sequentialSteps(const std::vector<int> &world, int N, int M, int D, int generations, int flag_3d){
+    std::vector<int> current = world, next(world.size());
+    for(int g = 0; g < generations; g++){
+        calculateStepSequential(current.data(), next.data(), N, M, D, flag_3d);
+        current.swap(next);
+    }
+    return current;
+}
+
+/** Runs generations of a Life-like rule on the host, the reference of the generated and padded kernels
+ *  calculateStepRule wraps around the world, so the dead and mirrored boundaries step a copy of
+ *  the world with a border of ghost cells, filled before every step with what the kernel reads
+ *  outside of the world, and keep the cells inside of the border
+ * @param rule rule to apply
+ * @param flag_3d if true treats the world as 3D, the border has planes too
+ * @param boundary what the cells on the edges see outside of the world
+ */
+static std::vector<int> ruleSteps(const std::vector<int> &world, int N, int M, int D, int generations, const LifeRule &rule, int flag_3d, Boundary boundary){
+    std::vector<int> current = world, next(world.size());
+    if(boundary == Boundary::Toroidal){
+        for(int g = 0; g < generations; g++){
+            calculateStepRule(current.data(), next.data(), N, M, D, rule, flag_3d);
+            current.swap(next);
+        }
+        return current;
+    }
+
+    const int border = flag_3d ? 1 : 0, PN = N + 2, PM = M + 2, PD = D + 2 * border;
+    std::vector<int> bordered((size_t)PN * PM * PD), stepped(bordered.size());
+    auto clamp = [](int x, int size){ return std::min(std::max(x, 0), size - 1); };
+    for(int g = 0; g < generations; g++){
+        for(int k = 0; k < PD; k++){
+            for(int i = 0; i < PN; i++){
+                for(int j = 0; j < PM; j++){
+                    int wk = k - border, wi = i - 1, wj = j - 1;
+                    bool inside = wk >= 0 && wk < D && wi >= 0 && wi < N && wj >= 0 && wj < M;
+                    int cell = 0;
+                    if(inside) cell = current[((size_t)wk * N + wi) * M + wj];
+                    else if(boundary == Boundary::Mirrored) cell = current[((size_t)clamp(wk, D) * N + clamp(wi, N)) * M + clamp(wj, M)];
+                    bordered[((size_t)k * PN + i) * PM + j] = cell;
+                }
+            }
+        }
+        calculateStepRule(bordered.data(), stepped.data(), PN, PM, PD, rule, flag_3d);
+        for(int k = 0; k < D; k++){
+            for(int i = 0; i < N; i++){
+                for(int j = 0; j < M; j++) current[((size_t)k * N + i) * M + j] = stepped[((size_t)(k + border) * PN + i + 1) * PM + j + 1];
+            }
+        }
+    }
+    return current;
+}
+
+/** Runs generations of a Larger than Life rule with LtlEngine, the reference of CalcStepLtl.cl */
+static std::vector<int> ltlSteps(const std::vector<int> &world, int N, int M, int D, int generations, const LtlRule &rule, int flag_3d){
+    LtlEngine engine;
+    engine.setRule(rule, flag_3d);
+    engine.load(world, N, M, D);
+    for(int g = 0; g < generations; g++) engine.step(flag_3d);
+    std::vector<int> result(world.size());
+    engine.store(result);
+    return result;
+}
+
+/** Runs a kernel with transfers on every step and on the device, and compares both with a reference
+ * @param name name of the kernel in the report
+ * @param q queue holding the kernel
+ * @param pipeline pipeline the steps on the device are enqueued with
+ * @param world initial world
+ * @param reference world after the generations, calculated on the host
+ * @param generations generations to run
+ * @param step runs a step with transfers on a world
+ * @param upload binds the step to the pipeline and copies a world to the device
+ * @param report prints the speed of both runs, otherwise only the ones that differ
+ * @return number of runs that differ from the reference, or whose frames allocate after the first one
+ */
+static int runKernel(const std::string &name, Queue &q, StepPipeline &pipeline, const std::vector<int> &world, const std::vector<int> &reference, int generations,
+                     const std::function<void(std::vector<int> &)> &step, const std::function<void(std::vector<int> &)> &upload, bool report){
+    std::vector<int> result(world.size()), frame(world.size());
+    int failures = 0;
+    for(int resident = 0; resident < 2; resident++){
+        result = world;
+        upload(result);
+
+        auto start = std::chrono::steady_clock::now();
+        size_t allocations = 0;
+        if(resident){
+            // the frames of the window: the next generation runs while the last one is read, the
+            // first one may size the wait list of the pipeline
+            pipeline.enqueue(q, 1);
+            for(int g = 1; g < generations; g++){
+                size_t before = allocationCount();
+                pipeline.enqueueRead(q, frame);
+                pipeline.enqueue(q, 1);
+                pipeline.waitRead();
+                if(g > 1) allocations += allocationCount() - before;
+            }
+            downloadWorld(q, result);
+        }
+        else for(int g = 0; g < generations; g++) step(result);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        bool matches = result == reference;
+        if(!matches || allocations) failures++;
+
+        if(report){
+            double cells_per_second = (double)world.size() * generations / elapsed.count();
+            std::cout << name << (resident ? " on the device: " : " with transfers: ") << elapsed.count() * 1000 / generations << " ms/generation, "
+                      << cells_per_second / 1e6 << " Mcells/s, " << (matches ? "matches" : "DIFFERS FROM") << " the host";
+            if(resident) std::cout << ", " << pipeline.enqueueMicroseconds() << " us of host time per launch, " << allocations << " allocations after the first frame";
+            std::cout << std::endl;
+        }
+        else if(!matches || allocations){
+            std::cout << name << (resident ? " on the device: " : " with transfers: ") << (matches ? "" : "DIFFERS FROM the host, ")
+                      << allocations << " allocations after the first frame" << std::endl;
+        }
+    }
+    return failures;
+}
+
+/** Runs the kernel of the awake tiles on a world whose second half starts empty, the tiles of
+ *  the empty half sleep until the other one reaches them. Sleeping tiles keep the cells the output
+ *  buffer holds from the step before, so it runs for many generations
+ * @param world world whose second half is cleared
+ * @param generations generations to run, at least 60
+ * @param report prints the speed of the kernel, otherwise only if it differs
+ * @return 1 if it differs from the sequential step
+ */
+static int runTiles(const std::vector<int> &world, int N, int M, int D, int generations, int flag_3d, bool report){
+    generations = std::max(generations, 60);
+    std::vector<int> half = world;
+    for(int k = 0; k < D; k++) std::fill(half.begin() + ((size_t)k * N + N / 2) * M, half.begin() + (size_t)(k + 1) * N * M, 0);
+    std::vector<int> reference = sequentialSteps(half, N, M, D, generations, flag_3d), result = half;
+
+    Queue q = initConway(N, M, D, 3, half);
+    TileTracker tiles;
+    auto start = std::chrono::steady_clock::now();
+    for(int g = 0; g < generations; g++) calculateStepTiles(N, M, D, q, result, flag_3d, tiles);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    bool matches = result == reference;
+    if(report){
+        double cells_per_second = (double)world.size() * generations / elapsed.count();
+        std::cout << "CalcStepTiles.cl with transfers: " << elapsed.count() * 1000 / generations << " ms/generation, "
+                  << cells_per_second / 1e6 << " Mcells/s, " << (matches ? "matches" : "DIFFERS FROM") << " the host after " << generations << " generations" << std::endl;
+    }
+    else if(!matches){
+        std::cout << "CalcStepTiles.cl on " << N << "x" << M << "x" << D << (flag_3d ? " 3D" : " 2D") << ": DIFFERS FROM the host" << std::endl;
+    }
+    return matches ? 0 : 1;
+}
+
+/** Runs every kernel on a random world of the given size
+ * @param gen generator of the world
+ * @param report prints the speed of every kernel, otherwise only the ones that differ
+ * @return number of runs that differ from their reference
+ */
+static int runKernels(int N, int M, int D, int generations, int flag_3d, std::mt19937 &gen, bool report){
+    std::vector<int> world = randomWorld(N, M, D, flag_3d, gen);
+    std::vector<int> reference = sequentialSteps(world, N, M, D, generations, flag_3d);
+    std::string size = report ? "" : " on " + std::to_string(N) + "x" + std::to_string(M) + "x" + std::to_string(D) + (flag_3d ? " 3D" : " 2D");
+    int failures = 0;
+
+    struct Kernel { const char *name; int type; };
+    const Kernel kernels[] = {{"CalcStep3D.cl", 0}, {"CalcStepSeparable.cl", 4}};
+    for(const Kernel &kernel : kernels){
+        Queue q = initConway(N, M, D, kernel.type, world);
+        StepPipeline pipeline;
+        failures += runKernel(kernel.name + size, q, pipeline, world, reference, generations,
+                              [&](std::vector<int> &w){ calculateStep(N, M, D, q, w, flag_3d); },
+                              [&](std::vector<int> &w){ prepareStep(pipeline, N, M, D, q, flag_3d); uploadWorld(q, w); }, report);
+    }
+
+    // the world split across devices, on one device and on two slabs of the same device, which exchange their edges
+    cl::Device device = selectDevice();
+    const std::vector<cl::Device> splits[] = {{device}, {device, device}};
+    for(const auto &devices : splits){
+        MultiDeviceWorld split(N, M, D, devices);
+        std::vector<int> result = world;
+        auto start = std::chrono::steady_clock::now();
+        split.upload(result);
+        for(int g = 0; g < generations; g++) split.step(flag_3d);
+        split.download(result);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        bool matches = result == reference;
+        if(!matches) failures++;
+        std::string name = "MultiDeviceWorld with " + std::to_string(split.devices()) + (split.devices() > 1 ? " slabs" : " slab");
+        if(report){
+            double cells_per_second = (double)world.size() * generations / elapsed.count();
+            std::cout << name << ": " << elapsed.count() * 1000 / generations << " ms/generation, " << cells_per_second / 1e6 << " Mcells/s, "
+                      << (matches ? "matches" : "DIFFERS FROM") << " the host, " << split.waitMicroseconds() << " us per step waiting for the edges" << std::endl;
+        }
+        else if(!matches) std::cout << name << size << ": DIFFERS FROM the host" << std::endl;
+    }
+
+    // the kernel generated for every boundary, with the rule of the simulation and a von Neumann rule
+    LifeRule von_neumann;
+    LifeRule::parse("B2/S12/V", von_neumann);
+    const LifeRule rules[] = {flag_3d ? conway_rule_3d : conway_rule_2d, von_neumann};
+    const char *boundaries[] = {"toroidal", "dead", "mirrored"};
+    Queue q = initConway(N, M, D, 5, world);
+    for(const LifeRule &rule : rules){
+        for(int b = 0; b < 3; b++){
+            Boundary boundary = (Boundary)b;
+            std::vector<int> rule_reference = ruleSteps(world, N, M, D, generations, rule, flag_3d, boundary);
+            StepPipeline pipeline;
+            failures += runKernel("CalcStepRule.cl " + rule.toString() + " " + boundaries[b] + size, q, pipeline, world, rule_reference, generations,
+                                  [&](std::vector<int> &w){ calculateStepGenerated(N, M, D, q, w, rule, flag_3d, boundary); },
+                                  [&](std::vector<int> &w){ prepareStepGenerated(pipeline, N, M, D, q, rule, flag_3d, boundary); uploadWorld(q, w); }, report);
+        }
+    }
+
+    // the world with its halo of ghost cells, the halo is filled on the device for every boundary
+    Queue padded = initConway(N, M, D, 7, world);
+    for(int b = 0; b < 3; b++){
+        Boundary boundary = (Boundary)b;
+        std::vector<int> padded_reference = ruleSteps(world, N, M, D, generations, rules[0], flag_3d, boundary);
+        StepPipeline pipeline;
+        failures += runKernel(std::string("CalcStepPadded.cl ") + boundaries[b] + size, padded, pipeline, world, padded_reference, generations,
+                              [&](std::vector<int> &w){ calculateStepPadded(N, M, D, padded, w, flag_3d, boundary); },
+                              [&](std::vector<int> &w){ prepareStepPadded(pipeline, N, M, D, padded, flag_3d, boundary); uploadPaddedWorld(N, M, D, padded, w, flag_3d, boundary); }, report);
+    }
+
+    // Larger than Life with a radius above 1, the boxes go around the small worlds more than once
+    const LtlRule ltl_rule = flag_3d ? LtlRule{3, 44, 60, 40, 70, true} : bosco_rule;
+    std::vector<int> ltl_reference = ltlSteps(world, N, M, D, generations, ltl_rule, flag_3d);
+    Queue ltl = initConway(N, M, D, 6, world);
+    StepPipeline ltl_pipeline;
+    failures += runKernel("CalcStepLtl.cl R" + std::to_string(ltl_rule.radius) + size, ltl, ltl_pipeline, world, ltl_reference, generations,
+                          [&](std::vector<int> &w){ calculateStepLtl(N, M, D, ltl, w, ltl_rule, flag_3d); },
+                          [&](std::vector<int> &w){ prepareStepLtl(ltl_pipeline, N, M, D, ltl, ltl_rule, flag_3d); uploadWorld(ltl, w); }, report);
+    return failures;
+}
+
+int main(int argc, char **argv){
+    int N = argc > 1 ? std::atoi(argv[1]) : 256;
+    int M = argc > 2 ? std::atoi(argv[2]) : 256;
+    int D = argc > 3 ? std::atoi(argv[3]) : 256;
+    int generations = argc > 4 ? std::atoi(argv[4]) : 10;
+    int flag_3d = argc > 5 ? std::atoi(argv[5]) : 1;
+
+    std::mt19937 gen(42);
+    std::cout << "World " << N << "x" << M << "x" << D << ", " << generations << " generations, "
+              << (flag_3d ? "3D" : "2D") << " rule" << std::endl;
+    int failures = runKernels(N, M, D, generations, flag_3d, gen, true);
+    failures += runTiles(randomWorld(N, M, D, flag_3d, gen), N, M, D, generations, flag_3d, true);
+    if(failures) std::cout << failures << " runs differ from the host or allocate after their first frame" << std::endl;
+
+    // sizes that aren't multiples of the work-groups, a single plane, planes of the 2D rule and
+    // worlds narrower than the boxes of Larger than Life
+    const int sizes[][4] = {{8, 8, 1, 0}, {4, 5, 1, 0}, {13, 21, 1, 0}, {13, 21, 3, 0}, {64, 64, 1, 0}, {2, 3, 2, 1}, {4, 4, 4, 1}, {9, 13, 5, 1}, {16, 16, 16, 1}};
+    int edge_failures = 0;
+    for(auto &size : sizes) edge_failures += runKernels(size[0], size[1], size[2], 12, size[3], gen, false);
+
+    // the empty half has tiles that only see empty tiles with eight tiles on the rows, and planes of
+    // the 2D rule don't wake each other
+    const int tile_sizes[][4] = {{256, 150, 1, 0}, {13, 21, 3, 0}, {64, 36, 24, 1}};
+    for(auto &size : tile_sizes) edge_failures += runTiles(randomWorld(size[0], size[1], size[2], size[3], gen), size[0], size[1], size[2], 60, size[3], false);
+    std::cout << "Edge sizes: " << (edge_failures ? "some kernels FAIL" : "every kernel matches the host without allocating") << std::endl;
+    failures += edge_failures;
+    return failures ? 1 : 0;
+}
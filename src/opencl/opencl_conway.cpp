@@ -6,8 +6,13 @@
 #include <vector>
 #include <cstdarg>
 #include <map>
+#include <cstdio>
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
 
 #include "opencl_conway.h"
+#include "program_cache.h"
 
 
 using std::chrono::microseconds;
@@ -15,19 +20,92 @@ using std::chrono::microseconds;
 #define block_size 64
 #define block_size_2d 8
 
+/* work-group of CalcStepSeparable.cl, columns x rows x planes */
+#define separable_cols 16
+#define separable_rows 4
+#define separable_planes 4
 
-Queue::Queue(){
-    std::cout << "Platform and device info\n";
+
+std::vector<cl::Device> listDevices(){
+    std::vector<cl::Device> all;
     std::vector<cl::Platform> platforms;
-    cl::Platform::get(&platforms);
-    _platform = platforms.front();
-    std::cout << "Platform: " << _platform.getInfo<CL_PLATFORM_NAME>()
-                << std::endl;
+    try{
+        cl::Platform::get(&platforms);
+    }
+    catch(cl::Error &){
+        // no platform installed
+        return all;
+    }
+    for(auto &platform : platforms){
+        std::vector<cl::Device> devices;
+        try{
+            platform.getDevices(CL_DEVICE_TYPE_ALL, &devices);
+        }
+        catch(cl::Error &){
+            continue;
+        }
+        all.insert(all.end(), devices.begin(), devices.end());
+    }
+    return all;
+}
 
-    std::vector<cl::Device> devices;
+/**
+ * Lower case copy of a string, device names are matched ignoring case
+ */
+static std::string lowerCase(std::string text){
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c){ return std::tolower(c); });
+    return text;
+}
 
-    _platform.getDevices(CL_DEVICE_TYPE_GPU, &devices);
-    _device = devices.front();
+cl::Device selectDevice(const std::string &selection){
+    std::vector<cl::Device> devices = listDevices();
+    if(devices.empty()) throw std::runtime_error("No OpenCL device found");
+
+    std::string wanted = selection;
+    if(wanted.empty() && std::getenv("CONWAY_OPENCL_DEVICE")) wanted = std::getenv("CONWAY_OPENCL_DEVICE");
+    wanted = lowerCase(wanted);
+
+    auto firstOfType = [&](cl_device_type type) -> const cl::Device* {
+        for(auto &device : devices) if(device.getInfo<CL_DEVICE_TYPE>() & type) return &device;
+        return nullptr;
+    };
+
+    if(!wanted.empty()){
+        const cl::Device *found = nullptr;
+        if(wanted == "gpu") found = firstOfType(CL_DEVICE_TYPE_GPU);
+        else if(wanted == "cpu") found = firstOfType(CL_DEVICE_TYPE_CPU);
+        else if(wanted == "accelerator") found = firstOfType(CL_DEVICE_TYPE_ACCELERATOR);
+        else if(std::all_of(wanted.begin(), wanted.end(), ::isdigit)){
+            size_t index = std::stoul(wanted);
+            if(index < devices.size()) found = &devices[index];
+        }
+        else{
+            for(auto &device : devices){
+                cl::Platform platform(device.getInfo<CL_DEVICE_PLATFORM>());
+                if(lowerCase(device.getInfo<CL_DEVICE_NAME>()).find(wanted) != std::string::npos ||
+                   lowerCase(platform.getInfo<CL_PLATFORM_NAME>()).find(wanted) != std::string::npos){
+                    found = &device;
+                    break;
+                }
+            }
+        }
+        if(found) return *found;
+        std::cerr << "No OpenCL device matches \"" << wanted << "\", using the default one" << std::endl;
+    }
+
+    // the first GPU, any device on hosts without one
+    const cl::Device *gpu = firstOfType(CL_DEVICE_TYPE_GPU);
+    return gpu ? *gpu : devices.front();
+}
+
+Queue::Queue() : Queue(selectDevice()){}
+
+Queue::Queue(const cl::Device &device){
+    std::cout << "Platform and device info\n";
+    _device = device;
+    _platform = cl::Platform(_device.getInfo<CL_DEVICE_PLATFORM>());
+    std::cout << "Platform: " << _platform.getInfo<CL_PLATFORM_NAME>()
+                << std::endl;
     std::cout << "Device: " << _device.getInfo<CL_DEVICE_NAME>()
                 << std::endl;
 
@@ -35,9 +113,11 @@ Queue::Queue(){
     std::cout << "Max sizes: " << maxWorkItems[0] << " " << maxWorkItems[1] << " " << maxWorkItems[2] << std::endl;
     std::cout << "Max group size: " << _device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>() << std::endl;
 
-    _context = cl::Context(devices);
+    _context = cl::Context(_device);
 
-    _queue = cl::CommandQueue(_context, _device); 
+    // profiling gives the start and end of the kernels and reads that overlap
+    _queue = cl::CommandQueue(_context, _device, CL_QUEUE_PROFILING_ENABLE);
+    _transfer = cl::CommandQueue(_context, _device, CL_QUEUE_PROFILING_ENABLE);
 }
 
 template <typename T>
@@ -56,14 +136,55 @@ void Queue::updateBuffer(std::vector<T> &data, int index){
 }
 
 // Lee el kernel de un archivo
-void Queue::setKernel(const std::string &file, const std::string &kernelName)
+void Queue::setKernel(const std::string &file, const std::string &kernelName, const std::string &options)
 {
+    _options = options;
+    _kernel_name = kernelName;
+    std::string key = file + "\n" + kernelName + "\n" + options;
+    auto cached = _kernels.find(key);
+    if(cached != _kernels.end()){
+        _program = cached->second.first;
+        _kernel = cached->second.second;
+        return;
+    }
+
     std::ifstream sourceFile(file);
     std::stringstream sourceCode;
     sourceCode << sourceFile.rdbuf();
-    _program = cl::Program(_context, sourceCode.str(), true);
+    std::string source = sourceCode.str();
+
+    // programs built before for the same device, driver, source and options are loaded from disk
+    std::string cacheKey = programCacheKey(_device.getInfo<CL_DEVICE_NAME>() + " " + _device.getInfo<CL_DEVICE_VERSION>(),
+                                           _device.getInfo<CL_DRIVER_VERSION>(), source, options);
+    std::vector<unsigned char> binary;
+    bool cached_binary = false;
+    if(loadProgramBinary(cacheKey, binary)){
+        try{
+            _program = cl::Program(_context, {_device}, cl::Program::Binaries{binary});
+            _program.build({_device}, options.c_str());
+            cached_binary = true;
+        }
+        catch(cl::Error &){
+            // the runtime rejected the binary, it is built from the source and replaced
+        }
+    }
+
+    if(!cached_binary){
+        _program = cl::Program(_context, source);
+        try{
+            _program.build(options.c_str());
+        }
+        catch(cl::Error &error){
+            std::cerr << "Build of " << file << " " << options << " failed:\n" << _program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(_device) << std::endl;
+            throw;
+        }
+        std::vector<std::vector<unsigned char>> binaries = _program.getInfo<CL_PROGRAM_BINARIES>();
+        if(!binaries.empty()) storeProgramBinary(cacheKey, binaries.front());
+    }
+    std::cout << "Kernel " << file << (options.empty() ? "" : " " + options) << (cached_binary ? ": cache hit" : ": cache miss, built") << std::endl;
 
     _kernel = cl::Kernel(_program, kernelName.c_str());
+    _kernels[key] = std::make_pair(_program, _kernel);
 }
 
 template <typename T>
@@ -92,6 +213,93 @@ cl::Event Queue::operator()(cl::NDRange globalSize, cl::NDRange localSize, Args.
 }
 
 
+/**
+ * Enqueues a copy of the world between the host and the first buffer of a queue, a padded world
+ * only copies its cells, rows go between the halo columns and planes between the halo rows
+ */
+static void enqueueWorldCopy(const Queue &q, const cl::CommandQueue &queue, bool read, std::vector<int> &world, cl_bool blocking,
+                             const std::vector<cl::Event> *events = nullptr, cl::Event *event = nullptr){
+    const PaddedLayout &layout = q.padding();
+    if(!layout.pitch){
+        if(read) queue.enqueueReadBuffer(q.buffer(0), blocking, 0, world.size() * sizeof(int), world.data(), events, event);
+        else queue.enqueueWriteBuffer(q.buffer(0), blocking, 0, world.size() * sizeof(int), world.data(), events, event);
+        return;
+    }
+
+    const cl::array<cl::size_type, 3> origin = {sizeof(int), 1, 1}, host_origin = {0, 0, 0};
+    const cl::array<cl::size_type, 3> region = {layout.M * sizeof(int), (cl::size_type)layout.N, (cl::size_type)layout.D};
+    const size_t row = layout.pitch * sizeof(int), plane = layout.plane_size * sizeof(int);
+    const size_t host_row = layout.M * sizeof(int), host_plane = (size_t)layout.N * layout.M * sizeof(int);
+    if(read) queue.enqueueReadBufferRect(q.buffer(0), blocking, origin, host_origin, region, row, plane, host_row, host_plane, world.data(), events, event);
+    else queue.enqueueWriteBufferRect(q.buffer(0), blocking, origin, host_origin, region, row, plane, host_row, host_plane, world.data(), events, event);
+}
+
+bool StepPipeline::configure(const Queue &q, const Config &config){
+    if(_queue == &q && _config == config && !_launches.empty()) return false;
+    _queue = &q;
+    _config = config;
+    _launches.clear();
+    _first = q.buffer(0);
+    return true;
+}
+
+void StepPipeline::enqueue(Queue &q, int generations){
+    auto start = std::chrono::steady_clock::now();
+    const cl::CommandQueue &queue = q.commandQueue();
+
+    // the kernels reading the first buffer bound run while it holds the world
+    int swapped = q.buffer(0)() == _first() ? 0 : 1;
+    for(int g = 0; g < generations; g++){
+        for(size_t l = 0; l < _launches.size(); l++){
+            const Launch &launch = _launches[l];
+            // the second generation writes the buffer a pending read is reading
+            bool after_read = _read_pending && g == 1 && l == 0;
+            cl::Event *event = g == 0 && l == 0 ? &_first_launch : (g == generations - 1 && l == _launches.size() - 1 ? &_last_launch : nullptr);
+            queue.enqueueNDRangeKernel(launch.kernels[swapped], cl::NullRange, launch.global, launch.local, after_read ? &_wait_list : nullptr, event);
+        }
+        swapped ^= 1;
+    }
+    if(generations == 1 && _launches.size() == 1) _last_launch = _first_launch;
+    queue.flush();
+    if(generations % 2) q.swapBuffers(0, 1);
+
+    if(_read_pending && generations > 0){
+        Overlap &overlap = _overlaps[0];
+        overlap.read = _read;
+        overlap.first = _first_launch;
+        overlap.last = _last_launch;
+        overlap.valid = true;
+    }
+
+    _enqueued += (uint64_t)generations * _launches.size();
+    _enqueue_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void StepPipeline::enqueueRead(const Queue &q, std::vector<int> &world){
+    _wait_list.assign(1, _last_launch);
+    enqueueWorldCopy(q, q.transferQueue(), true, world, CL_FALSE, &_wait_list, &_read);
+    q.transferQueue().flush();
+    _wait_list.assign(1, _read);
+    _read_pending = true;
+}
+
+void StepPipeline::waitRead(){
+    if(!_read_pending) return;
+    _read.wait();
+    _read_pending = false;
+
+    // the batch after the read of the last frame is done, it was read now
+    Overlap &done = _overlaps[1];
+    if(done.valid){
+        cl_ulong read_start = done.read.getProfilingInfo<CL_PROFILING_COMMAND_START>(), read_end = done.read.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+        cl_ulong compute_start = done.first.getProfilingInfo<CL_PROFILING_COMMAND_START>(), compute_end = done.last.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+        cl_ulong begin = std::max(read_start, compute_start), end = std::min(read_end, compute_end);
+        _overlap = read_end > read_start && end > begin ? (double)(end - begin) / (read_end - read_start) : 0;
+    }
+    std::swap(_overlaps[0], _overlaps[1]);
+    _overlaps[0].valid = false;
+}
+
 /**
  * Initializes the world with several gliders in different places
  * 
@@ -150,22 +358,73 @@ void report(std::string rep){
     std::cout << rep << std::endl;
 }
 
+/**
+ * Writes the build options of CalcStepRule.cl for a configuration, without allocating
+ */
+static void generatedOptions(char *options, size_t size, int N, int M, int D, const LifeRule &rule, int flag_3d, Boundary boundary){
+    snprintf(options, size, "-D N=%d -D M=%d -D D=%d -D BIRTH=%uu -D SURVIVE=%uu -D DIMS=%d -D VON_NEUMANN=%d -D BOUNDARY=%d",
+             N, M, D, rule.birth, rule.survive, flag_3d ? 3 : 2, rule.neighbourhood == Neighbourhood::VonNeumann, (int)boundary);
+}
+
 Queue initConway(int N, int M, int D, int type, std::vector<int> &nextState){
     Queue q;
-    initWorld(nextState, N, M);
 
-    q.addBuffer(nextState, CL_MEM_READ_ONLY);
-    q.addBuffer(nextState, CL_MEM_WRITE_ONLY);
+    // current and next generation, they swap roles on the steps on the device. Type 7 keeps the
+    // world with its halo of ghost cells in both of them
+    if(type == 7){
+        PaddedLayout layout(N, M, D, sizeof(int));
+        std::vector<int> padded(layout.size());
+        q.addBuffer(padded, CL_MEM_READ_WRITE);
+        q.addBuffer(padded, CL_MEM_READ_WRITE);
+        q.setPadding(layout);
+    }
+    else{
+        q.addBuffer(nextState, CL_MEM_READ_WRITE);
+        q.addBuffer(nextState, CL_MEM_READ_WRITE);
+    }
 
     std::string source;
-    if(D == 1) source = type == 0 ? "kernel/CalcStep.cl" : (type == 1 ? "kernel/CalcStep2D.cl" : "kernel/CalcStepGroups.cl");
+    if(type == 3){
+        // lists of awake tiles and flags of changed tiles
+        std::vector<int> tiles(TileTracker::maxTiles(N, M, D));
+        q.addBuffer(tiles, CL_MEM_READ_ONLY);
+        q.addBuffer(tiles, CL_MEM_READ_WRITE);
+        source = "kernel/CalcStepTiles.cl";
+    }
+    else if(type == 6){
+        // sums along the rows and along the rows and columns
+        std::vector<int> sums(N * M * D);
+        q.addBuffer(sums, CL_MEM_READ_WRITE);
+        q.addBuffer(sums, CL_MEM_READ_WRITE);
+        source = "kernel/CalcStepLtl.cl";
+    }
+    else if(type == 7) source = "kernel/CalcStepPadded.cl";
+    else if(type == 4) source = "kernel/CalcStepSeparable.cl";
+    else if(type == 5) source = "kernel/CalcStepRule.cl";
+    else if(D == 1 && type != 0) source = type == 1 ? "kernel/CalcStep2D.cl" : "kernel/CalcStepGroups.cl";
     else source = "kernel/CalcStep3D.cl";
-    q.setKernel(source, "calcStep");
+    if(type == 5){
+        char options[256];
+        generatedOptions(options, sizeof(options), N, M, D, conway_rule_2d, 0, Boundary::Toroidal);
+        q.setKernel(source, "calcStep", options);
+    }
+    else q.setKernel(source, "calcStep");
 
-    if(type == 0){
+    if(type == 3){
         q.globalSize = cl::NDRange(N * M * D);
         q.localSize = cl::NDRange(block_size);
     }
+    else if(type == 0 || type >= 5){
+        // the kernel skips the threads past the end of the world
+        q.globalSize = cl::NDRange((N * M * D + block_size - 1) / block_size * block_size);
+        q.localSize = cl::NDRange(block_size);
+    }
+    else if(type == 4){
+        // one thread per cell, rounded up to whole groups
+        auto roundUp = [](int size, int group){ return (size + group - 1) / group * group; };
+        q.globalSize = cl::NDRange(roundUp(M, separable_cols), roundUp(N, separable_rows), roundUp(D, separable_planes));
+        q.localSize = cl::NDRange(separable_cols, separable_rows, separable_planes);
+    }
     else{
         q.globalSize = cl::NDRange(N, M);
         q.localSize = cl::NDRange(block_size_2d, block_size_2d);
@@ -175,9 +434,258 @@ Queue initConway(int N, int M, int D, int type, std::vector<int> &nextState){
 }
 
 
-void calculateStep(int N, int M, int D, Queue q, std::vector<int> &nextState, int flag_3d){
-    q.updateBuffer(nextState, 0);
-    cl::Event event = q(q.globalSize, q.localSize, N, M, D, flag_3d);
-    event.wait();
-    q.readBuffer(nextState, 1);
+void uploadWorld(Queue &q, std::vector<int> &world){
+    enqueueWorldCopy(q, q.commandQueue(), false, world, CL_TRUE);
+}
+
+void downloadWorld(Queue &q, std::vector<int> &world){
+    enqueueWorldCopy(q, q.commandQueue(), true, world, CL_TRUE);
+}
+
+void calculateStep(int N, int M, int D, Queue &q, std::vector<int> &nextState, int flag_3d){
+    uploadWorld(q, nextState);
+    q(q.globalSize, q.localSize, N, M, D, flag_3d);
+    q.swapBuffers(0, 1);
+    downloadWorld(q, nextState);
+}
+
+void calculateStepTiles(int N, int M, int D, Queue &q, std::vector<int> &nextState, int flag_3d, TileTracker &tiles){
+    tiles.configure(N, M, D, flag_3d);
+    std::vector<int> &awake = tiles.prepare();
+
+    if(!awake.empty()){
+        std::vector<int> &changed = tiles.changed();
+        q.updateBuffer(nextState, 0);
+        q.updateBuffer(awake, 2);
+        q.updateBuffer(changed, 3);
+
+        // one thread per cell of every awake tile, tiles are multiples of block_size
+        cl::NDRange globalSize(awake.size() * tiles.tileCells());
+        q(globalSize, q.localSize, N, M, D, flag_3d, tiles.tileRows(), tiles.tileCols(), tiles.tilePlanes());
+
+        q.readBuffer(nextState, 1);
+        q.readBuffer(changed, 3);
+    }
+    tiles.finish();
+}
+
+void calculateStepGenerated(int N, int M, int D, Queue &q, std::vector<int> &nextState, const LifeRule &rule, int flag_3d, Boundary boundary){
+    // the kernel only changes with the configuration
+    char options[256];
+    generatedOptions(options, sizeof(options), N, M, D, rule, flag_3d, boundary);
+    if(q.options() != options) q.setKernel("kernel/CalcStepRule.cl", "calcStep", options);
+
+    uploadWorld(q, nextState);
+    q(q.globalSize, q.localSize);
+    q.swapBuffers(0, 1);
+    downloadWorld(q, nextState);
+}
+
+void calculateStepLtl(int N, int M, int D, Queue &q, std::vector<int> &nextState, const LtlRule &rule, int flag_3d){
+    auto roundUp = [](int size){ return (size + block_size - 1) / block_size * block_size; };
+    // lines of every pass: rows, columns of every plane and cells of a plane
+    const int lines[3] = {N * D, M * D, N * M};
+    const int R = std::min(std::max(rule.radius, 1), (int)LtlRule::max_radius);
+
+    uploadWorld(q, nextState);
+    for(int pass = 0; pass < (flag_3d ? 3 : 2); pass++){
+        q(cl::NDRange(roundUp(lines[pass])), q.localSize, N, M, D, flag_3d, R,
+          rule.birth_min, rule.birth_max, rule.survive_min, rule.survive_max, (int)rule.count_center, pass);
+    }
+    q.swapBuffers(0, 1);
+    downloadWorld(q, nextState);
+}
+
+/* ranges of the passes of CalcStepPadded.cl: the cells on columns, rows and planes, and one thread per ghost cell */
+static cl::NDRange paddedCells(int N, int M, int D){
+    auto roundUp = [](int size){ return (size + block_size_2d - 1) / block_size_2d * block_size_2d; };
+    return cl::NDRange(roundUp(M), roundUp(N), D);
+}
+
+static cl::NDRange paddedHalo(const PaddedLayout &layout, int flag_3d){
+    return cl::NDRange((layout.haloCells(flag_3d) + block_size - 1) / block_size * block_size);
+}
+
+void uploadPaddedWorld(int N, int M, int D, Queue &q, std::vector<int> &world, int flag_3d, Boundary boundary){
+    const PaddedLayout &layout = q.padding();
+    uploadWorld(q, world);
+    q(paddedHalo(layout, flag_3d), cl::NDRange(block_size), N, M, D, layout.pitch, flag_3d, (int)boundary, 2);
+}
+
+void calculateStepPadded(int N, int M, int D, Queue &q, std::vector<int> &nextState, int flag_3d, Boundary boundary){
+    const PaddedLayout &layout = q.padding();
+    uploadPaddedWorld(N, M, D, q, nextState, flag_3d, boundary);
+    q(paddedCells(N, M, D), cl::NDRange(block_size_2d, block_size_2d, 1), N, M, D, layout.pitch, flag_3d, (int)boundary, 0);
+    q(paddedHalo(layout, flag_3d), cl::NDRange(block_size), N, M, D, layout.pitch, flag_3d, (int)boundary, 1);
+    q.swapBuffers(0, 1);
+    downloadWorld(q, nextState);
+}
+
+void prepareStep(StepPipeline &pipeline, int N, int M, int D, Queue &q, int flag_3d){
+    if(pipeline.configure(q, {0, N, M, D, flag_3d})) pipeline.add(q.globalSize, q.localSize, N, M, D, flag_3d);
+}
+
+void prepareStepGenerated(StepPipeline &pipeline, int N, int M, int D, Queue &q, const LifeRule &rule, int flag_3d, Boundary boundary){
+    char options[256];
+    generatedOptions(options, sizeof(options), N, M, D, rule, flag_3d, boundary);
+    if(q.options() != options) q.setKernel("kernel/CalcStepRule.cl", "calcStep", options);
+
+    StepPipeline::Config config = {5, N, M, D, flag_3d, (int)boundary, (int)rule.birth, (int)rule.survive, rule.neighbourhood == Neighbourhood::VonNeumann};
+    if(pipeline.configure(q, config)) pipeline.add(q.globalSize, q.localSize);
+}
+
+void prepareStepLtl(StepPipeline &pipeline, int N, int M, int D, Queue &q, const LtlRule &rule, int flag_3d){
+    auto roundUp = [](int size){ return (size + block_size - 1) / block_size * block_size; };
+    const int lines[3] = {N * D, M * D, N * M};
+    const int R = std::min(std::max(rule.radius, 1), (int)LtlRule::max_radius);
+
+    StepPipeline::Config config = {6, N, M, D, flag_3d, R, rule.birth_min, rule.birth_max, rule.survive_min, rule.survive_max, (int)rule.count_center};
+    if(!pipeline.configure(q, config)) return;
+    for(int pass = 0; pass < (flag_3d ? 3 : 2); pass++){
+        pipeline.add(cl::NDRange(roundUp(lines[pass])), q.localSize, N, M, D, flag_3d, R,
+                     rule.birth_min, rule.birth_max, rule.survive_min, rule.survive_max, (int)rule.count_center, pass);
+    }
+}
+
+bool prepareStepPadded(StepPipeline &pipeline, int N, int M, int D, Queue &q, int flag_3d, Boundary boundary){
+    const PaddedLayout &layout = q.padding();
+    if(!pipeline.configure(q, {7, N, M, D, flag_3d, (int)boundary})) return false;
+    pipeline.add(paddedCells(N, M, D), cl::NDRange(block_size_2d, block_size_2d, 1), N, M, D, layout.pitch, flag_3d, (int)boundary, 0);
+    pipeline.add(paddedHalo(layout, flag_3d), cl::NDRange(block_size), N, M, D, layout.pitch, flag_3d, (int)boundary, 1);
+    return true;
+}
+
+MultiDeviceWorld::MultiDeviceWorld(int N, int M, int D, const std::vector<cl::Device> &devices) : _N(N), _M(M), _D(D){
+    if(devices.empty()) throw std::runtime_error("No OpenCL device found");
+    int count = std::min((int)devices.size(), D);
+    _slabs.reserve(count);
+    for(int d = 0; d < count; d++){
+        _slabs.emplace_back(devices[d]);
+        Slab &slab = _slabs.back();
+        slab.begin = (int64_t)D * d / count;
+        slab.planes = (int64_t)D * (d + 1) / count - slab.begin;
+
+        // two buffers of the slab, and its halo planes apart, only written while the edge planes aren't calculated
+        std::vector<int> buffer((size_t)slab.planes * N * M), halo(2 * (size_t)N * M);
+        slab.queue.addBuffer(buffer, CL_MEM_READ_WRITE);
+        slab.queue.addBuffer(buffer, CL_MEM_READ_WRITE);
+        slab.queue.addBuffer(halo, CL_MEM_READ_ONLY);
+        slab.queue.setKernel("kernel/CalcStepSlab.cl", "calcStep");
+        slab.edges[0].resize(2 * (size_t)N * M);
+        slab.edges[1].resize(2 * (size_t)N * M);
+        slab.after_step.reserve(2);
+        slab.halo_step.reserve(1);
+    }
+}
+
+void MultiDeviceWorld::bind(int flag_3d){
+    _flag_3d = flag_3d;
+    for(Slab &slab : _slabs){
+        int planes = slab.planes;
+        // inner planes, the first and last ones, and every plane
+        const int ranges[3][3] = {{1, 1, std::max(planes - 2, 0)}, {0, std::max(planes - 1, 1), std::min(planes, 2)}, {0, 1, planes}};
+        for(int parity = 0; parity < 2; parity++){
+            for(int r = 0; r < 3; r++){
+                cl::Kernel &kernel = slab.kernels[parity][r] = slab.queue.newKernel();
+                kernel.setArg(0, slab.queue.buffer(parity));
+                kernel.setArg(1, slab.queue.buffer(2));
+                kernel.setArg(2, slab.queue.buffer(1 - parity));
+                kernel.setArg(3, _N);
+                kernel.setArg(4, _M);
+                kernel.setArg(5, planes);
+                kernel.setArg(6, flag_3d);
+                kernel.setArg(7, ranges[r][0]);
+                kernel.setArg(8, ranges[r][1]);
+                kernel.setArg(9, ranges[r][2]);
+            }
+        }
+    }
+}
+
+void MultiDeviceWorld::upload(const std::vector<int> &world){
+    const size_t plane_size = (size_t)_N * _M;
+    for(Slab &slab : _slabs){
+        slab.queue.transferQueue().finish();
+        slab.queue.commandQueue().enqueueWriteBuffer(slab.queue.buffer(_current), CL_TRUE, 0, plane_size * slab.planes * sizeof(int),
+                                                     world.data() + slab.begin * plane_size);
+        slab.after_step.clear();
+        slab.halo_step.clear();
+    }
+}
+
+void MultiDeviceWorld::download(std::vector<int> &world){
+    const size_t plane_size = (size_t)_N * _M;
+    // the reads of every device run at the same time
+    for(Slab &slab : _slabs){
+        slab.queue.commandQueue().enqueueReadBuffer(slab.queue.buffer(_current), CL_FALSE, 0, plane_size * slab.planes * sizeof(int),
+                                                    world.data() + slab.begin * plane_size);
+    }
+    for(Slab &slab : _slabs) slab.queue.commandQueue().finish();
+}
+
+void MultiDeviceWorld::step(int flag_3d){
+    if(flag_3d != _flag_3d) bind(flag_3d);
+    const size_t plane_size = (size_t)_N * _M, plane_bytes = plane_size * sizeof(int);
+    auto globalSize = [&](int planes){ return cl::NDRange((plane_size * planes + block_size - 1) / block_size * block_size); };
+
+    // the kernels are recorded even in 2D, a later 3D step reads the edges on the other queue after them
+    if(!flag_3d){
+        for(Slab &slab : _slabs){
+            const cl::CommandQueue &queue = slab.queue.commandQueue();
+            slab.after_step.clear();
+            slab.after_step.emplace_back();
+            queue.enqueueNDRangeKernel(slab.kernels[_current][2], cl::NullRange, globalSize(slab.planes), cl::NDRange(block_size), nullptr, &slab.after_step.back());
+            queue.flush();
+        }
+        _current ^= 1;
+        _steps++;
+        return;
+    }
+
+    // the edges are read while the inner planes are calculated
+    for(Slab &slab : _slabs){
+        const cl::CommandQueue &transfer = slab.queue.transferQueue(), &queue = slab.queue.commandQueue();
+        const cl::Buffer &current = slab.queue.buffer(_current);
+        const std::vector<cl::Event> *after = slab.after_step.empty() ? nullptr : &slab.after_step;
+        std::vector<int> &edges = slab.edges[_exchange];
+        transfer.enqueueReadBuffer(current, CL_FALSE, 0, plane_bytes, edges.data(), after, &slab.reads[0]);
+        transfer.enqueueReadBuffer(current, CL_FALSE, plane_bytes * (slab.planes - 1), plane_bytes, edges.data() + plane_size, after, &slab.reads[1]);
+        transfer.flush();
+
+        slab.after_step.clear();
+        if(slab.planes > 2){
+            slab.after_step.emplace_back();
+            queue.enqueueNDRangeKernel(slab.kernels[_current][0], cl::NullRange, globalSize(slab.planes - 2), cl::NDRange(block_size), nullptr, &slab.after_step.back());
+        }
+        queue.flush();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for(Slab &slab : _slabs){
+        slab.reads[0].wait();
+        slab.reads[1].wait();
+    }
+    _wait_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // the halos take the last plane of the slab before and the first plane of the slab after, their
+    // buffer is only read by the kernel of the edge planes, so it is written once the last one is done
+    int count = _slabs.size();
+    for(int s = 0; s < count; s++){
+        Slab &slab = _slabs[s];
+        const std::vector<int> &before = _slabs[(s + count - 1) % count].edges[_exchange], &after = _slabs[(s + 1) % count].edges[_exchange];
+        const cl::CommandQueue &transfer = slab.queue.transferQueue(), &queue = slab.queue.commandQueue();
+        const cl::Buffer &halo = slab.queue.buffer(2);
+        const std::vector<cl::Event> *edge_step = slab.halo_step.empty() ? nullptr : &slab.halo_step;
+        transfer.enqueueWriteBuffer(halo, CL_FALSE, 0, plane_bytes, before.data() + plane_size, edge_step, &slab.writes[0]);
+        transfer.enqueueWriteBuffer(halo, CL_FALSE, plane_bytes, plane_bytes, after.data(), edge_step, &slab.writes[1]);
+        transfer.flush();
+
+        slab.after_step.emplace_back();
+        queue.enqueueNDRangeKernel(slab.kernels[_current][1], cl::NullRange, globalSize(std::min(slab.planes, 2)), cl::NDRange(block_size), &slab.writes, &slab.after_step.back());
+        slab.halo_step.assign(1, slab.after_step.back());
+        queue.flush();
+    }
+    _current ^= 1;
+    _exchange ^= 1;
+    _steps++;
 }
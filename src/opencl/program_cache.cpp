@@ -0,0 +1,89 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include <unistd.h>
+
+#include "program_cache.h"
+
+static const char cache_magic[8] = {'C', 'O', 'N', 'W', 'A', 'Y', 'C', 'L'};
+
+/** 64 bit FNV-1a hash of a text */
+static uint64_t fnv1a(const std::string &text){
+    uint64_t hash = 14695981039346656037ull;
+    for(unsigned char c : text){
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static std::string hex(uint64_t value){
+    char text[17];
+    snprintf(text, sizeof(text), "%016llx", (unsigned long long)value);
+    return text;
+}
+
+/** File of a key in the cache, empty if the cache is disabled */
+static std::filesystem::path cachePath(const std::string &key){
+    const char *directory = std::getenv("CONWAY_KERNEL_CACHE");
+    std::filesystem::path path = directory ? directory : "kernel/cache";
+    if(path.empty()) return path;
+    return path / (hex(fnv1a(key)) + ".bin");
+}
+
+std::string programCacheKey(const std::string &device, const std::string &driver, const std::string &source, const std::string &options){
+    return "device " + device + "\ndriver " + driver + "\nsource " + hex(fnv1a(source)) + "\noptions " + options + "\n";
+}
+
+bool loadProgramBinary(const std::string &key, std::vector<unsigned char> &binary){
+    std::filesystem::path path = cachePath(key);
+    if(path.empty()) return false;
+    std::ifstream file(path, std::ios::binary);
+    if(!file) return false;
+
+    // the file starts with the whole key, two keys with the same hash don't mix
+    char magic[sizeof(cache_magic)];
+    uint32_t key_size = 0;
+    file.read(magic, sizeof(magic));
+    file.read((char*)&key_size, sizeof(key_size));
+    if(!file || std::memcmp(magic, cache_magic, sizeof(magic)) != 0 || key_size != key.size()) return false;
+    std::string stored(key_size, '\0');
+    file.read(&stored[0], key_size);
+    if(!file || stored != key) return false;
+
+    binary.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !binary.empty();
+}
+
+void storeProgramBinary(const std::string &key, const std::vector<unsigned char> &binary){
+    std::filesystem::path path = cachePath(key);
+    if(path.empty() || binary.empty()) return;
+
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    // written aside and renamed, so other processes never read half a file
+    std::filesystem::path temporary = path;
+    temporary += "." + std::to_string(getpid());
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        uint32_t key_size = key.size();
+        file.write(cache_magic, sizeof(cache_magic));
+        file.write((const char*)&key_size, sizeof(key_size));
+        file.write(key.data(), key.size());
+        file.write((const char*)binary.data(), binary.size());
+        if(!file){
+            std::cerr << "Can't write the kernel cache " << temporary << std::endl;
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    if(error) std::filesystem::remove(temporary, error);
+}
@@ -0,0 +1,45 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "streaming_conway.h"
+
+/* Steps a 3D world stored in a file with the out of core engine, so the world can be larger
+ * than memory: 4096x4096x4096 cells take 8 GB on disk and 48 MB of memory. The world file is
+ * created with random cells if it doesn't exist, the next generation is written to
+ * <world file>.next and the two files swap roles every generation.
+ *
+ * usage: conway_stream <world file> [generations] [rows] [cols] [planes] [2d]
+ */
+
+int main(int argc, char **argv){
+    if(argc < 2){
+        std::cerr << "usage: conway_stream <world file> [generations] [rows] [cols] [planes] [2d]" << std::endl;
+        return 1;
+    }
+    std::string path = argv[1];
+    int generations = argc > 2 ? std::atoi(argv[2]) : 1;
+    int N = argc > 3 ? std::atoi(argv[3]) : 1024;
+    int M = argc > 4 ? std::atoi(argv[4]) : N;
+    int D = argc > 5 ? std::atoi(argv[5]) : N;
+    int flag_3d = argc > 6 ? !std::atoi(argv[6]) : 1;
+
+    StreamingEngine engine;
+    if(!engine.open(path)){
+        std::cout << "Creating " << N << "x" << M << "x" << D << " world in " << path << std::endl;
+        if(!StreamingEngine::createWorldFile(path, N, M, D, 0.3, 42) || !engine.open(path)){
+            std::cerr << "Can't create " << path << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "World " << engine.rows() << "x" << engine.cols() << "x" << engine.planes() << " at generation " << engine.generation() << std::endl;
+
+    for(int g = 0; g < generations; g++){
+        engine.step(flag_3d);
+        std::cout << "Generation " << engine.generation() << ": " << engine.planesPerSecond() << " planes/s, "
+                  << engine.planesPerSecond() * engine.rows() * engine.cols() / 1e6 << " Mcells/s" << std::endl;
+    }
+    std::cout << "Last generation in " << engine.currentPath() << std::endl;
+    return 0;
+}
@@ -1,33 +1,48 @@
 
 
+#include <algorithm>
 #include <random>
+#include <chrono>
+#include <cstdio>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include "utils.h"
 
-/** Returns 1d coordinates from 3d coordinates
- * @param i x coordinate
- * @param j y coordinate
- * @param k z coordiante
- * @param N number of rows
- * @param M number of columns
- * @param D number of planes
- */
-int worldIdx(int i, int j, int k, const int N, const int M, const int D){
-    k = (k + D) % D;
-    i = (i + N) % N;
-    j = (j + M) % M;
-	return k * N * M + i * M + j;
-}
-
 Controller::Controller(int width, int height){
     rows = width * SIM_SCALE / CELL_SIZE, cols = height * SIM_SCALE / CELL_SIZE, planes = rows;
     WIDTH = width, HEIGHT = height;
 
     next_state.resize(rows * cols * planes);
-    q_3d = initConway(rows, cols, planes, 0, next_state);
+    back_state.resize(next_state.size());
+    readback_state.resize(next_state.size());
+    initWorld(next_state, rows, cols);
     cell_gl_size = 2.0f * SIM_SCALE / (float)rows;
+
+    engines.emplace_back(new BitPackedEngine());
+    engines.emplace_back(new LutEngine());
+    engines.emplace_back(new SimdEngine());
+    engines.emplace_back(new ThreadedEngine());
+    engines.emplace_back(brick_engine = new BrickEngine());
+    engines.emplace_back(hashlife_engine = new HashLifeEngine());
+    engines.emplace_back(incremental_engine = new IncrementalEngine());
+    engines.emplace_back(sparse_engine = new SparseEngine());
+    engines.emplace_back(temporal_engine = new TemporalEngine(temporal_generations));
+    engines.emplace_back(new SeparableEngine());
+    engines.emplace_back(ltl_engine = new LtlEngine());
+    engines.emplace_back(padded_engine = new PaddedEngine());
+    engines.emplace_back(streaming_engine = new StreamingEngine());
+
+    lighted_cells_positions.reserve(max_light_cells * 3);
+    light_generator.seed(std::random_device()());
+
+    simulation_names = {"Sequential", "Parallel"};
+    for(auto &engine : engines) simulation_names.push_back(engine->name());
+}
+
+void Controller::add_distributed_engine(Transport &transport){
+    engines.emplace_back(distributed_engine = new DistributedEngine(transport));
+    simulation_names.push_back(distributed_engine->name());
 }
 
 void Controller::add_n_random_glider(int n){
@@ -65,10 +80,30 @@ void Controller::add_n_random_glider(int n){
         }
 
     }
+    world_changed();
 }
 
 void Controller::kill_world(){
     std::fill(next_state.begin(), next_state.end(), 0);
+    world_changed();
+}
+
+void Controller::world_changed(){
+    loaded_engine = -1;
+    edited_engine = -1;
+    device_queue = nullptr;
+    multi_device_loaded = false;
+    tiles_path = -1;
+}
+
+void Controller::world_edited(){
+    int engine = loaded_engine >= 0 ? loaded_engine : edited_engine;
+    world_changed();
+    edited_engine = engine;
+}
+
+bool Controller::engine_active(const Engine *engine){
+    return simulation_type >= 2 && loaded_engine == simulation_type - 2 && engines[loaded_engine].get() == engine;
 }
 
 unsigned int Controller::load_shader(std::string path, bool shader_type){
@@ -118,17 +153,10 @@ unsigned int Controller::create_shader_program(unsigned int vertex, unsigned int
     return program;
 }
 
-int Controller::update_with_step(unsigned int &positions, std::vector<int> &result, std::vector<float> coords, int N, int M, int D){
-    int number_of_active_cells = 0;
-
-    std::vector <float> new_positions;
-    for(int i = 0; i < N*M*D; i++){
-        if(result[i]){
-            new_positions.insert(new_positions.end(), {coords[i*3], coords[i*3 + 1], coords[i*3 + 2]});
-            number_of_active_cells+=1;
-        }
-    }
-
+int Controller::update_with_step(unsigned int &positions, const std::vector<int> &result, const std::vector<float> &coords, int N, int M, int D){
+    /*scratch of this frame*/
+    std::pmr::vector<float> new_positions(&frame_arena);
+    int number_of_active_cells = gatherLiveCells(result, coords, (size_t)N*M*D, new_positions);
 
     glBindBuffer(GL_ARRAY_BUFFER, positions);
     glBufferData(GL_ARRAY_BUFFER, sizeof(float)*new_positions.size(), new_positions.data(), GL_DYNAMIC_DRAW);
@@ -210,11 +238,14 @@ std::vector<float> Controller::grid_points_3d(){
 }
 
 void Controller::fill_lighted_cells(std::vector<float> &points){
-    std::random_device rd; 
-    std::mt19937 gen(rd()); 
-    std::uniform_int_distribution<> distr(0, points.size()/3);
-    while(lighted_cells_positions.size()/3 < internal_number_of_light_cells){
-        int random_point = distr(gen);
+    /*an empty world has no cells to light, they are picked once cells are alive*/
+    if(points.size() < 3){
+        internal_number_of_light_cells = lighted_cells_positions.size()/3;
+        return;
+    }
+    std::uniform_int_distribution<size_t> distr(0, points.size()/3 - 1);
+    while(lighted_cells_positions.size()/3 < (size_t)internal_number_of_light_cells){
+        size_t random_point = distr(light_generator);
         lighted_cells_positions.insert(lighted_cells_positions.end(), {points[random_point*3], points[random_point*3 + 1], points[random_point*3 + 2]});
     }
 }
@@ -253,13 +284,124 @@ void Controller::renderImgui(GLFWwindow* window, ImGuiIO &io){
         const char* items2[] = { "Phong", "Normal" };
         ImGui::Combo("Coloring", &coloring_style, items2, IM_ARRAYSIZE(items2));
 
-        const char* items3[] = {"Sequential", "Parallel"};
-        ImGui::Combo("Type of simulation", &parallel_simualtion, items3, IM_ARRAYSIZE(items3));
+        ImGui::Combo("Type of simulation", &simulation_type, simulation_names.data(), simulation_names.size());
+
+        if(simulation_type == 1){
+            const char* kernels[] = {"Per cell", "Separable sums", "Generated for the rule", "Larger than Life", "Ghost cells", "All devices"};
+            ImGui::Combo("Kernel", &parallel_kernel, kernels, IM_ARRAYSIZE(kernels));
+            /*the queue of a kernel is created the first time it is selected, the slabs of every device the first time they run*/
+            if(parallel_kernel == 5 && !skip_stable_tiles){
+                if(multi_device){
+                    for(int d = 0; d < multi_device->devices(); d++) ImGui::Text("%s: %d planes", multi_device->deviceName(d).c_str(), multi_device->slabPlanes(d));
+                    ImGui::Text("Waiting for the slab edges %.1f us per generation", multi_device->waitMicroseconds());
+                }
+            }
+            else ImGui::Text("Device: %s", queue(skip_stable_tiles ? 3 : parallel_type()).deviceName().c_str());
+            if(parallel_kernel == 2) ImGui::Text("Kernels built %zu", queue(5).kernelsBuilt());
+            if(!skip_stable_tiles){
+                ImGui::SliderInt("Generations per frame", &parallel_generations, 1, 64);
+                ImGui::Text("Host time per launch %.2f us", pipeline.enqueueMicroseconds());
+                ImGui::Text("Readback overlapped with kernels %.0f%%", pipeline.overlapPercentage());
+            }
+        }
 
-        ImGui::SliderInt("Light Cells", &number_of_light_cells, 0, 20);
+        bool padded_selected = simulation_type >= 2 && engines[simulation_type - 2].get() == padded_engine;
+        if((simulation_type == 1 && (parallel_kernel == 2 || parallel_kernel == 4)) || padded_selected){
+            const char* boundaries[] = {"Toroidal", "Dead", "Mirrored"};
+            ImGui::Combo("Boundary", &boundary, boundaries, IM_ARRAYSIZE(boundaries));
+            padded_engine->setBoundary((Boundary)boundary);
+        }
+
+        bool ltl_selected = (simulation_type == 1 && parallel_kernel == 3) || (simulation_type >= 2 && engines[simulation_type - 2].get() == ltl_engine);
+        if(ltl_selected){
+            LtlRule &rule = ltl_rules[style_3d];
+            ImGui::SliderInt("Radius", &rule.radius, 1, LtlRule::max_radius);
+            int side = 2 * rule.radius + 1, box = style_3d ? side * side * side : side * side;
+            ImGui::DragIntRange2("Birth", &rule.birth_min, &rule.birth_max, 1.0f, 0, box);
+            ImGui::DragIntRange2("Survival", &rule.survive_min, &rule.survive_max, 1.0f, 0, box);
+            ImGui::Checkbox("Count the cell", &rule.count_center);
+            ltl_engine->setRule(rule, style_3d);
+        }
+        else if(ImGui::InputText("Rule", rule_text[style_3d], sizeof(rule_text[style_3d]))){
+            rule_valid = LifeRule::parse(rule_text[style_3d], rules[style_3d]);
+        }
+        if(ltl_selected) ImGui::Text("R%d B%d-%d S%d-%d%s", ltl_rules[style_3d].radius, ltl_rules[style_3d].birth_min, ltl_rules[style_3d].birth_max,
+                                     ltl_rules[style_3d].survive_min, ltl_rules[style_3d].survive_max, ltl_rules[style_3d].count_center ? " counting the cell" : "");
+        else if(!rule_valid) ImGui::Text("Invalid rule, use B3/S23, B5/S4,5 or B1/S12/V for von Neumann");
+        else if(simulation_type == 0) ImGui::Text("%s kernel for %s", ruleSpecialized(rules[style_3d], style_3d) ? "Specialized" : "Generic", rules[style_3d].toString().c_str());
+        else if(simulation_type == 1 && parallel_kernel == 2 && !skip_stable_tiles) ImGui::Text("Kernel built for %s", rules[style_3d].toString().c_str());
+        else if(custom_rule()) ImGui::Text("Only the sequential simulation and the generated kernel use custom rules");
+        ImGui::Checkbox("Skip stable tiles", &skip_stable_tiles);
+        if(skip_stable_tiles && tiles_path != -1) ImGui::Text("Tiles awake %d of %d", tiles.awakeTiles(), tiles.totalTiles());
+
+        ImGui::SliderInt("Light Cells", &number_of_light_cells, 0, max_light_cells);
         ImGui::SliderFloat("Brightness", &light_cells_intensity, 0, 1);
 
 
+        if(simulation_type >= 2 && engines[simulation_type - 2].get() == hashlife_engine){
+            ImGui::SliderInt("Jump 2^k generations", &hashlife_jump, 0, 40);
+            ImGui::SliderInt("Memory cap (MB)", &hashlife_memory_cap, 16, 8192);
+            hashlife_engine->setJump(hashlife_jump);
+            hashlife_engine->setMemoryCap((size_t)hashlife_memory_cap << 20);
+            if(engine_active(hashlife_engine)){
+                ImGui::Text("Generation %llu", (unsigned long long)hashlife_engine->generation());
+                ImGui::Text("Nodes %zu (%.1f MB), %d collections", hashlife_engine->nodes(), hashlife_engine->memoryUsed() / 1048576.0, hashlife_engine->collections());
+            }
+        }
+
+        if(engine_active(incremental_engine)){
+            ImGui::Text("Cells changed %zu, evaluated %zu", incremental_engine->changed(), incremental_engine->evaluated());
+        }
+
+        if(simulation_type >= 2 && engines[simulation_type - 2].get() == sparse_engine){
+            ImGui::Checkbox("Follow pattern", &follow_pattern);
+            sparse_engine->setFollow(follow_pattern);
+            if(engine_active(sparse_engine)){
+                const SparseEngine::Box &box = sparse_engine->boundingBox();
+                if(box.empty) ImGui::Text("Bounding box empty");
+                else ImGui::Text("Bounding box (%lld, %lld, %lld) to (%lld, %lld, %lld)", box.min_i, box.min_j, box.min_k, box.max_i, box.max_j, box.max_k);
+                ImGui::Text("Window at (%lld, %lld, %lld), %zu chunks (%.1f MB)", sparse_engine->viewRow(), sparse_engine->viewCol(), sparse_engine->viewPlane(), sparse_engine->chunks(), sparse_engine->memoryUsed() / 1048576.0);
+            }
+        }
+
+        if(simulation_type >= 2 && engines[simulation_type - 2].get() == temporal_engine){
+            ImGui::SliderInt("Generations per pass", &temporal_generations, 1, TemporalEngine::max_generations);
+            temporal_engine->setGenerations(temporal_generations);
+        }
+
+        if(engine_active(streaming_engine)){
+            ImGui::Text("Generation %llu, %.0f planes/s", (unsigned long long)streaming_engine->generation(), streaming_engine->planesPerSecond());
+            ImGui::Text("World file %s", streaming_engine->currentPath().c_str());
+        }
+
+        if(engine_active(distributed_engine)){
+            double busy = distributed_engine->computeSeconds() + distributed_engine->waitSeconds();
+            ImGui::Text("%d ranks, %d with rows, generation %llu", distributed_engine->ranks(), distributed_engine->activeRanks(), (unsigned long long)distributed_engine->generation());
+            ImGui::Text("Rank 0 waited for halos %.1f%% of its step", busy > 0 ? 100.0 * distributed_engine->waitSeconds() / busy : 0.0);
+        }
+
+        if(engine_active(brick_engine)){
+            ImGui::Text("Bricks calculated: %d of %d", brick_engine->activeBricks(), brick_engine->totalBricks());
+            const std::vector<BrickEngine::WorkerStats> &stats = brick_engine->stats();
+            for(size_t w = 0; w < stats.size(); w++){
+                char label[64];
+                snprintf(label, sizeof(label), "Worker %zu: %d bricks, %d stolen", w, stats[w].bricks, stats[w].steals);
+                ImGui::ProgressBar(stats[w].utilisation, ImVec2(-1, 0), label);
+            }
+        }
+
+        double generations = simulation_type >= 2 ? (double)engines[simulation_type - 2]->generationsPerStep() : simulation_type == 1 && !skip_stable_tiles ? parallel_generations : 1.0;
+        ImGui::Text("Step %.3f ms (%.1f Mcells/s), %zu allocations", step_ms, step_ms > 0 ? next_state.size() * generations / (step_ms * 1000.0) : 0.0, step_allocations);
+        WorldMemoryStats memory = worldMemoryStats();
+        if(memory.mappings){
+            ImGui::Text("World memory %.1f MB in %zu mappings, %.1f MB on huge pages (%.1f MB explicit)", memory.bytes / 1048576.0, memory.mappings,
+                        memory.huge_bytes / 1048576.0, memory.explicit_huge_bytes / 1048576.0);
+            ImGui::Text("%d NUMA nodes, %d threads pinned", memory.nodes, memory.pinned_threads);
+            for(int node = 0; node < std::min(memory.nodes, (int)WorldMemoryStats::max_nodes); node++){
+                if(memory.node_bytes[node]) ImGui::Text("Node %d: %.1f MB placed by its workers", node, memory.node_bytes[node] / 1048576.0);
+            }
+        }
+        ImGui::Text("Frame %zu allocations, scratch %.1f of %.1f MB", frame_allocations, frame_arena.peak() / 1048576.0, frame_arena.capacity() / 1048576.0);
         ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
         ImGui::End();
     }
@@ -271,33 +413,135 @@ void Controller::renderImgui(GLFWwindow* window, ImGuiIO &io){
     glfwGetFramebufferSize(window, &display_w, &display_h);
 }
 
+bool Controller::custom_rule(){
+    return rules[style_3d] != (style_3d ? conway_rule_3d : conway_rule_2d);
+}
+
 void Controller::calculateStepSecuentially(){
+    /*tiles only know the default rules*/
+    if(skip_stable_tiles && !custom_rule()){
+        /*tiles only know what changed if the last step was also done here, a sleeping tile
+          didn't change on the step before so both buffers already hold its cells*/
+        if(tiles_path != 0) tiles.wakeAll();
+        calculateStepSequentialTiles(next_state.data(), back_state.data(), rows, cols, planes, style_3d, tiles);
+        next_state.swap(back_state);
+        tiles_path = 0;
+        return;
+    }
 
-    std::vector<int> temp(next_state.size());
-    
-    for(int gindex = 0; gindex < next_state.size(); gindex++){
-        int k = gindex / (rows * cols);  
-        int i = (gindex % (rows * cols)) / cols;
-        int j = (gindex % (rows * cols)) % cols;
-        int neighbours = next_state[worldIdx(i - 1, j - 1, k, rows, cols, planes)] + next_state[worldIdx(i - 1, j, k, rows, cols, planes)] + next_state[worldIdx(i - 1, j + 1, k, rows, cols, planes)] + // same k
-                        next_state[worldIdx(i, j - 1, k, rows, cols, planes)] + next_state[worldIdx(i, j + 1, k, rows, cols, planes)] +
-                        next_state[worldIdx(i + 1, j - 1, k, rows, cols, planes)] + next_state[worldIdx(i + 1, j, k, rows, cols, planes)] + next_state[worldIdx(i + 1, j + 1, k, rows, cols, planes)];
+    calculateStepRule(next_state.data(), back_state.data(), rows, cols, planes, rules[style_3d], style_3d);
+    next_state.swap(back_state);
+    tiles_path = -1;
+}
 
-        if(style_3d){
-            neighbours +=   next_state[worldIdx(i - 1, j - 1, k+1, rows, cols, planes)] + next_state[worldIdx(i - 1, j, k+1, rows, cols, planes)] + next_state[worldIdx(i - 1, j + 1, k+1, rows, cols, planes)] + // next k
-                            next_state[worldIdx(i, j - 1, k+1, rows, cols, planes)] + next_state[worldIdx(i, j + 1, k+1, rows, cols, planes)] + next_state[worldIdx(i, j, k+1, rows, cols, planes)] +
-                            next_state[worldIdx(i + 1, j - 1, k+1, rows, cols, planes)] + next_state[worldIdx(i + 1, j, k+1, rows, cols, planes)] + next_state[worldIdx(i + 1, j + 1, k+1, rows, cols, planes)] +
-                            next_state[worldIdx(i - 1, j - 1, k-1, rows, cols, planes)] + next_state[worldIdx(i - 1, j, k-1, rows, cols, planes)] + next_state[worldIdx(i - 1, j + 1, k-1, rows, cols, planes)] + // last k
-                            next_state[worldIdx(i, j - 1, k-1, rows, cols, planes)] + next_state[worldIdx(i, j + 1, k-1, rows, cols, planes)] + next_state[worldIdx(i, j, k-1, rows, cols, planes)] +
-                            next_state[worldIdx(i + 1, j - 1, k-1, rows, cols, planes)] + next_state[worldIdx(i + 1, j, k-1, rows, cols, planes)] + next_state[worldIdx(i + 1, j + 1, k-1, rows, cols, planes)];
-            temp[gindex] = next_state[gindex] && (4 <= neighbours && neighbours <= 5) || !next_state[gindex] && neighbours == 5;
-        }
-        else{
-            temp[gindex] = neighbours == 3 || (neighbours == 2 && next_state[gindex]);        
-        }
+void Controller::calculateStepParallel(){
+    if(skip_stable_tiles){
+        /*sleeping tiles are taken from the output buffer of the last step, it has to be this one*/
+        if(tiles_path != 1) tiles.wakeAll();
+        calculateStepTiles(rows, cols, planes, queue(3), next_state, style_3d == 1, tiles);
+        tiles_path = 1;
+        device_queue = nullptr;
+        multi_device_loaded = false;
+        return;
+    }
+
+    /*the world split across every device, it stays on them between frames*/
+    if(parallel_kernel == 5){
+        if(!multi_device) multi_device.reset(new MultiDeviceWorld(rows, cols, planes));
+        if(!multi_device_loaded) multi_device->upload(next_state);
+        for(int g = 0; g < parallel_generations; g++) multi_device->step(style_3d);
+        multi_device->download(next_state);
+        multi_device_loaded = true;
+        device_queue = nullptr;
+        tiles_path = -1;
+        return;
     }
+    multi_device_loaded = false;
 
-    std::copy(temp.begin(), temp.end(), next_state.begin());   
+    Queue &q = queue(parallel_type());
+
+    /*the halo of the padded world on the device was filled for the last boundary*/
+    if(parallel_kernel == 4){
+        if(prepareStepPadded(pipeline, rows, cols, planes, q, style_3d, (Boundary)boundary)) device_queue = nullptr;
+    }
+    else if(parallel_kernel == 3) prepareStepLtl(pipeline, rows, cols, planes, q, ltl_rules[style_3d], style_3d);
+    else if(parallel_kernel == 2) prepareStepGenerated(pipeline, rows, cols, planes, q, rules[style_3d], style_3d, (Boundary)boundary);
+    else prepareStep(pipeline, rows, cols, planes, q, style_3d == 1);
+
+    /*the world stays on the device, it is only copied in after it changed on the host*/
+    if(device_queue != &q){
+        if(parallel_kernel == 4) uploadPaddedWorld(rows, cols, planes, q, next_state, style_3d, (Boundary)boundary);
+        else uploadWorld(q, next_state);
+        pipeline.enqueue(q, parallel_generations);
+        device_queue = &q;
+    }
+
+    /*the device is one frame ahead: the generations of this frame are read back while
+      the ones of the next frame run, and calculated while this one is drawn*/
+    pipeline.enqueueRead(q, readback_state);
+    pipeline.enqueue(q, parallel_generations);
+    pipeline.waitRead();
+    next_state.swap(readback_state);
+    tiles_path = -1;
+}
+
+Queue &Controller::queue(int type){
+    auto found = queues.find(type);
+    if(found == queues.end()) found = queues.emplace(type, initConway(rows, cols, planes, type, next_state)).first;
+    return found->second;
+}
+
+int Controller::parallel_type() const{
+    const int types[] = {0, 4, 5, 6, 7};
+    return parallel_kernel < 5 ? types[parallel_kernel] : 0;
+}
+
+void Controller::begin_frame(){
+    size_t allocations = allocationCount();
+    frame_allocations = allocations - frame_start_allocations;
+    frame_start_allocations = allocations;
+    frame_arena.reset();
+}
+
+void Controller::step(){
+    auto start = std::chrono::steady_clock::now();
+    size_t allocations = allocationCount();
+
+    if(simulation_type == 0) calculateStepSecuentially();
+    else if(simulation_type == 1) calculateStepParallel();
+    else calculateStepWithEngine();
+
+    if(simulation_type < 2) loaded_engine = edited_engine = -1;
+    if(simulation_type != 1){
+        device_queue = nullptr;
+        multi_device_loaded = false;
+    }
+
+    std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    step_ms = elapsed.count();
+    step_allocations = allocationCount() - allocations;
+}
+
+void Controller::calculateStepWithEngine(){
+    int index = simulation_type - 2;
+    Engine &engine = *engines[index];
+
+    /*engines without a 3D rule fall back to the sequential step*/
+    if(style_3d && !engine.supports_3d()){
+        calculateStepSecuentially();
+        loaded_engine = edited_engine = -1;
+        return;
+    }
+
+    if(loaded_engine != index){
+        if(edited_engine == index) engine.edit(next_state, rows, cols, planes);
+        else engine.load(next_state, rows, cols, planes);
+        loaded_engine = index;
+        edited_engine = -1;
+    }
+    engine.step(style_3d);
+    engine.store(next_state);
+    tiles_path = -1;
 }
 
 void Camera::update(){
@@ -379,13 +623,8 @@ void Window::init_glfw_window(int width, int height, const char *title){
 }
 
 void Window::internal_key_callback(int key, int action){
-    if (key == GLFW_KEY_SPACE && action == GLFW_PRESS){
-        /*update buffer with possible chanegs*/
-        if(!(controller->style_3d)){
-            controller->q_3d.updateBuffer(controller->next_state, 0);
-        }
-        controller->running = !controller->running;
-    }
+    /*edits reach the device through world_edited, the world on the device may be newer than the one shown*/
+    if (key == GLFW_KEY_SPACE && action == GLFW_PRESS) controller->running = !controller->running;
 
     if(key == GLFW_KEY_UP && action == GLFW_PRESS && controller->current_fps < 60) controller->current_fps += 1;
     if(key == GLFW_KEY_DOWN && action == GLFW_PRESS && controller->current_fps > 1) controller->current_fps -= 1;
@@ -435,6 +674,7 @@ void Window::internal_mouse_button_callback(int button, int action, int mods)
             int cell_i = (ypos - min_simulation) / controller->CELL_SIZE, cell_j = (xpos - min_simulation) / controller->CELL_SIZE;
 
             controller->next_state[cell_i + cell_j * controller->cols] = !controller->next_state[cell_i + cell_j * controller->cols];
+            controller->world_edited();
         }
     }
 }